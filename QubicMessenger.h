@@ -7,7 +7,7 @@
  *   - User registration (nickname → X25519 pubkey mapping)
  *   - Pubkey lookup by nickname
  *   - On-chain message metadata (hash + sender/receiver) for delivery proof
- *   - Nonce-based anti-replay protection
+ *   - Nonce-based anti-replay protection, with one nonce lane per device
  *   - Pubkey rotation for registered users
  *
  * NOTE: Message content is NEVER stored on-chain.
@@ -23,60 +23,888 @@ using namespace QPI;
 #define QM_PUBKEY_LEN      32   // X25519 public key (32 bytes)
 #define QM_HASH_LEN        32   // BLAKE2b-256 hash of encrypted blob
 #define QM_MSG_LOG_SIZE    65536  // ring buffer for message metadata
+#define QM_RANGE_MAX       64     // entries per range read (64 x 128 B keeps the output at 8 KiB)
+#define QM_BATCH_MAX       15     // entries per PostMessageMetaBatch (15 x 68 B fits a 1024 B input)
+
+// Per-user token bucket for posting procedures. Its shape depends on the
+// user's balance tier (TIERS in token-gate.ts): bursts of up to
+// QM_RATE_CAPACITY_<tier> posts, one token back every QM_RATE_REFILL_TICKS_<tier>
+// ticks. The tier is cached and re-read from the balance at most once per epoch.
+#define QM_TIER_FREE          0
+#define QM_TIER_SILVER        1
+#define QM_TIER_GOLD          2
+#define QM_TIER_DIAMOND       3
+
+#define QM_TIER_SILVER_MIN_BALANCE    1000LL
+#define QM_TIER_GOLD_MIN_BALANCE      10000LL
+#define QM_TIER_DIAMOND_MIN_BALANCE   100000LL
+
+#define QM_RATE_CAPACITY_FREE         5
+#define QM_RATE_CAPACITY_SILVER       10
+#define QM_RATE_CAPACITY_GOLD         20
+#define QM_RATE_CAPACITY_DIAMOND      40
+#define QM_RATE_REFILL_TICKS_FREE     10
+#define QM_RATE_REFILL_TICKS_SILVER   5
+#define QM_RATE_REFILL_TICKS_GOLD     2
+#define QM_RATE_REFILL_TICKS_DIAMOND  1
+
+// Anti-replay window (as in IPsec): any unseen nonce within the last
+// QM_NONCE_WINDOW below the highest one accepted is still valid
+#define QM_NONCE_WINDOW       64
+
+// Independent nonce lanes per user, one per device; lane 0 always exists
+#define QM_MAX_LANES          4
+
+// Open-addressing indexes over the user registry. Sized at 2x QM_MAX_USERS so
+// the load factor never exceeds 0.5. Every probe sequence is capped at
+// QM_INDEX_MAX_PROBES, so no lookup or insert costs more than that many
+// positions; a key whose window is full is rejected rather than stored
+// further out (RegisterUser -4, PostMessageMeta errorCode 5).
+#define QM_USER_INDEX_SIZE   16384
+#define QM_INDEX_MAX_PROBES  64
+#define QM_INDEX_EMPTY       0           // never used
+#define QM_INDEX_TOMBSTONE   0xFFFFFFFF  // deleted, keep probing past it
+#define QM_INDEX_SHIFT_BUDGET 256        // max positions one erase may scan
+
+// Index kinds for the shared insert/erase helpers
+#define QM_INDEX_OWNER       0
+#define QM_INDEX_NICKNAME    1
+#define QM_INDEX_EXT         2
+#define QM_INDEX_CONTENT     3
+
+// Unregistered receivers are interned into a refcounted id table so log
+// entries can name them with a 4-byte handle like registered users. The
+// table is kept small; posts to new unregistered ids are rejected while it
+// is full.
+#define QM_EXT_ID_SIZE       16384
+#define QM_EXT_INDEX_SIZE    32768
+#define QM_REF_TYPE_MASK     0xC0000000  // top two receiverRef bits; 0 = user slot
+#define QM_REF_EXTERNAL      0x80000000  // low bits index extIds[]
+#define QM_REF_MULTICAST     0x40000000  // low bits: count << QM_MCAST_RING_BITS | ring start
+#define QM_REF_BATCH_ROOT    0xC0000000  // low bits: leaf count, no receiver
+
+// Multicast entries store the content hash once and list registered
+// receivers by slot in a shared FIFO ring. Entries leave the log in seq
+// order, so their receiver runs are released in ring order too. When live
+// runs leave no room, a multicast is written as one direct entry per
+// receiver instead, which also evicts old entries and drains the ring.
+// 30 receiver ids still fit a 1024-byte input.
+#define QM_MCAST_MAX_RECEIVERS 30
+#define QM_MCAST_RING_BITS     18
+#define QM_MCAST_RING_SIZE     262144  // 1 << QM_MCAST_RING_BITS receivers across live entries
+
+// Entry kinds, as reported in QM_MessageMeta.kind and hashed into MMR leaves
+#define QM_KIND_DIRECT       0
+#define QM_KIND_MULTICAST    1
+#define QM_KIND_BATCH_ROOT   2
+
+// Batch roots commit to a Merkle tree over up to 2^QM_BATCH_TREE_DEPTH
+// (receiver, contentHash, nonce) leaves, padded with NULL_ID to a power of two
+#define QM_BATCH_TREE_DEPTH  24
+
+// contentHash -> ring position index for delivery proofs (2x QM_MSG_LOG_SIZE).
+// Content hashes are caller-chosen, so the index is keyed with a seed drawn
+// afresh each epoch and rebuilt under it; probes stay capped at
+// QM_INDEX_MAX_PROBES and an entry whose window is full is left unindexed.
+#define QM_HASH_INDEX_SIZE   131072
+
+// Entries with one content hash that a single VerifyDelivery call will check
+// for the requested sender and receiver, oldest first
+#define QM_DELIVERY_MAX_WALK 256
+
+// Merkle Mountain Range over every entry ever posted (leaf seq - 1). Nodes at
+// height h are kept in a ring of (QM_MSG_LOG_SIZE >> h) + 4 slots, enough to
+// prove any entry the message ring still holds.
+#define QM_MMR_MAX_HEIGHT    64
+#define QM_MMR_NODE_SLOTS    (2 * QM_MSG_LOG_SIZE + 4 * QM_MMR_MAX_HEIGHT)
+
+// Every QM_SEGMENT_SIZE entries the finished MMR subtree is filed in a table
+// that outlives the ring: 16384 segments cover the last 16M entries.
+#define QM_SEGMENT_BITS       10
+#define QM_SEGMENT_SIZE       1024  // 1 << QM_SEGMENT_BITS
+#define QM_SEGMENT_TABLE_SIZE 16384
 
 // ─── Data Structures ─────────────────────────────────────────────────────────
 
-struct QM_UserRecord {
-    uint8  nickname[QM_NICKNAME_LEN];
-    uint8  pubkey[QM_PUBKEY_LEN];
-    id     owner;            // Qubic wallet identity that owns this nickname
-    uint32 registeredTick;
-    uint32 lastUpdateTick;
-    uint8  active;           // 1 = active, 0 = deactivated
+struct QM_MessageMeta {
+    id     sender;
+    id     receiver;
+    uint8  contentHash[QM_HASH_LEN];
+    uint32 tick;
+    uint32 nonce;
+    uint64 seq;              // global sequence number, 1-based, never reused
+    uint8  kind;             // QM_KIND_*; multicast entries carry receiver = NULL_ID
+                             // except in inbox pages, see GetMulticastReceivers
+    uint32 leafCount;        // batch roots only, else 0
 };
 
-struct QM_MessageMeta {
+// Compact ring entry: parties are 4-byte handles that expand back to ids on
+// read, so an entry takes 56 bytes instead of a 128-byte QM_MessageMeta.
+struct QM_LogEntry {
+    uint64 seq;
+    uint8  contentHash[QM_HASH_LEN];
+    uint32 senderSlot;   // user slot (pinned while referenced, see userLogRefs)
+    uint32 receiverRef;  // user slot, QM_REF_EXTERNAL | extIds[] index,
+                         // QM_REF_MULTICAST | receiver run (see _mcastStart),
+                         // or QM_REF_BATCH_ROOT | leaf count
+    uint32 tick;
+    uint32 nonce;
+};
+
+// MMR leaf preimage. Spelled out to 128 bytes so no compiler padding is hashed.
+struct QM_MmrLeaf {
     id     sender;
     id     receiver;
     uint8  contentHash[QM_HASH_LEN];
+    uint64 seq;
     uint32 tick;
     uint32 nonce;
+    uint64 kind;         // QM_KIND_*
+    uint64 aux;          // batch roots: leaf count, else zero
+};
+
+// Leaf preimage of a batch-root tree (padded to 96 bytes, no compiler padding)
+struct QM_BatchLeaf {
+    id     receiver;
+    uint8  contentHash[QM_HASH_LEN];
+    uint32 nonce;
+    uint32 reserved[7];  // zero
+};
+
+// Receiver list of a multicast entry, hashed as the leaf's receiver
+struct QM_MmrReceivers {
+    id receivers[QM_MCAST_MAX_RECEIVERS];  // zero past the receiver count
+};
+
+// MMR interior node preimage: K12(left || right)
+struct QM_MmrPair {
+    id left;
+    id right;
+};
+
+// Digest of log segment k: seqs [k * QM_SEGMENT_SIZE + 1, (k + 1) * QM_SEGMENT_SIZE].
+// root is the MMR node at height QM_SEGMENT_BITS over those leaves.
+struct QM_Segment {
+    id     root;
+    uint64 firstSeq;   // 0 = table slot never written
+    uint32 firstTick;
+    uint32 lastTick;
+    uint16 epoch;      // epoch in which the segment closed
+};
+
+// One page of a per-user chain walk (GetInbox / GetOutbox)
+struct QM_MessagePage {
+    QM_MessageMeta entries[QM_RANGE_MAX];  // newest first
+    uint64 nextBeforeSeq;  // non-zero if more entries remain: pass as beforeSeq
+    uint32 count;
+    uint8  truncated;      // 1 if the chain ran into evicted entries before sinceSeq
 };
 
 // ─── Contract ─────────────────────────────────────────────────────────────────
 
 struct QubicMessenger {
 
-    QM_UserRecord  users[QM_MAX_USERS];
-    uint32         userCount;
+    // User registry, stored column-wise by slot index. Lookups only touch the
+    // active bitmap and one key column; pubkeys and ticks stay cold.
+    uint64         userActive[QM_MAX_USERS / 64];               // bit per slot: 1 = active
+    id             userOwner[QM_MAX_USERS];                     // Qubic wallet identity that owns the nickname
+    uint8          userNickname[QM_MAX_USERS][QM_NICKNAME_LEN];
+    uint8          userPubkey[QM_MAX_USERS][QM_PUBKEY_LEN];
+    uint32         userRegisteredTick[QM_MAX_USERS];
+    uint32         userLastUpdateTick[QM_MAX_USERS];
+    uint32         userCount;  // high-water mark: slots [0, userCount) have been handed out
+
+    // Stack of deactivated slots, reused by RegisterUser before growing userCount
+    uint32         freeSlots[QM_MAX_USERS];
+    uint32         freeCount;
+
+    // Replay window per user and device lane: highest nonce accepted, and a
+    // bitmap where bit i set means nonceMax - i has been used
+    uint32         nonceMax[QM_MAX_USERS][QM_MAX_LANES];
+    uint64         nonceWindow[QM_MAX_USERS][QM_MAX_LANES];
+    uint8          laneCount[QM_MAX_USERS];  // lanes [0, laneCount) are open
+
+    // Token bucket per user, refilled lazily on the next post
+    uint32         rateTokens[QM_MAX_USERS];
+    uint32         rateTick[QM_MAX_USERS];   // tick up to which refills have been credited
+    uint8          userTier[QM_MAX_USERS];   // QM_TIER_*, cached from the owner's balance
+    uint16         userTierEpoch[QM_MAX_USERS];  // epoch userTier was read in
+
+    // Ring buffer for message metadata log. Entry seq s lives at
+    // msgLog[s % QM_MSG_LOG_SIZE]; a stored seq of 0 means never written.
+    QM_LogEntry    msgLog[QM_MSG_LOG_SIZE];
+    uint64         msgSeq;   // seq of the newest entry, 0 = empty log
+
+    // Live log entries naming each user slot as sender or receiver. A
+    // deactivated slot only returns to the free list once this drops to 0, so
+    // a handle always expands to the id that owned the slot when it was posted.
+    uint32         userLogRefs[QM_MAX_USERS];
+
+    // Interned ids of unregistered receivers, refcounted by live log entries
+    id             extIds[QM_EXT_ID_SIZE];
+    uint32         extRefs[QM_EXT_ID_SIZE];
+    uint32         extFree[QM_EXT_ID_SIZE];  // stack of released extIds[] indexes
+    uint32         extFreeCount;
+    uint32         extCount;                 // high-water mark of extIds[]
+    uint32         extIndex[QM_EXT_INDEX_SIZE];  // id -> extIds[] index + 1
 
-    // Per-user monotonic nonce (index aligned with users[])
-    uint32         lastNonce[QM_MAX_USERS];
+    // Receiver runs of live multicast entries. Position p holds a receiver
+    // slot (pinned through userLogRefs) and the previous seq in its inbox.
+    uint32         mcastSlots[QM_MCAST_RING_SIZE];
+    uint64         mcastPrev[QM_MCAST_RING_SIZE];
+    uint64         mcastHead;  // receivers ever written; next run starts at mcastHead % size
+    uint64         mcastTail;  // receivers ever released
 
-    // Tick of last PostMessageMeta per user (rate limiting)
-    uint32         lastPostTick[QM_MAX_USERS];
+    // contentHash -> msgLog position + 1 of the oldest live entry with that
+    // hash. Later entries with the same hash queue behind it in seq order:
+    // hashNext[p] is the next one's position + 1 (0 = none), and hashTail[p]
+    // the last one's position, kept for the indexed entry only.
+    uint32         hashIndex[QM_HASH_INDEX_SIZE];
+    uint32         hashNext[QM_MSG_LOG_SIZE];
+    uint32         hashTail[QM_MSG_LOG_SIZE];
+    uint64         hashSeed;       // key of _hashContent, 0 = not drawn yet
+    uint16         hashSeedEpoch;  // epoch hashSeed was drawn in
 
-    // Ring buffer for message metadata log
-    QM_MessageMeta msgLog[QM_MSG_LOG_SIZE];
-    uint32         msgHead;  // next write position
+    // Per-receiver inbox chain: newest seq addressed to each registered user,
+    // and for every log entry the previous seq with the same receiver (0 = none).
+    // Only receivers that are registered at post time are linked.
+    uint64         inboxHead[QM_MAX_USERS];
+    uint64         inboxPrev[QM_MSG_LOG_SIZE];
+
+    // Per-sender outbox chain, mirroring the inbox chain
+    uint64         outboxHead[QM_MAX_USERS];
+    uint64         outboxPrev[QM_MSG_LOG_SIZE];
+
+    // Inbox watermark counters, maintained alongside inboxHead
+    uint32         inboxCount[QM_MAX_USERS];     // entries ever linked since registration
+    uint32         inboxLastTick[QM_MAX_USERS];  // tick of the newest linked entry
+
+    // Merkle Mountain Range over the log. The leaf count is msgSeq; peak h
+    // exists while bit h of msgSeq is set. Peaks and roots never depend on
+    // ring contents, so they stay valid after entries are evicted.
+    id             mmrPeaks[QM_MMR_MAX_HEIGHT];
+    id             mmrNodes[QM_MMR_NODE_SLOTS];  // per-height node rings, see _mmrNodeSlot
+
+    // Closed log segments, segment k at segments[k % QM_SEGMENT_TABLE_SIZE]
+    QM_Segment     segments[QM_SEGMENT_TABLE_SIZE];
+
+    // Owner id -> slot index for active users (entries hold slot + 1)
+    uint32         ownerIndex[QM_USER_INDEX_SIZE];
+
+    // Nickname -> slot index for active users (entries hold slot + 1)
+    uint32         nicknameIndex[QM_USER_INDEX_SIZE];
 
     // ── Helpers (inlined for QPI compatibility) ───────────────────────────────
 
+    uint8 _isActive(uint32 slot) {
+        return (uint8)((userActive[slot / 64] >> (slot % 64)) & 1);
+    }
+
+    void _setActive(uint32 slot, uint8 active) {
+        if (active) userActive[slot / 64] |=  (1ULL << (slot % 64));
+        else        userActive[slot / 64] &= ~(1ULL << (slot % 64));
+    }
+
+    static uint32 _hashId(const id& value) {
+        // ids are public keys, so their low word is already well mixed
+        return (uint32)(value.u64._0 ^ (value.u64._0 >> 32));
+    }
+
+    // FNV-1a: nicknames share long null-padded tails, so they are not
+    // trusted to be uniformly distributed
+    static uint32 _hashBytes(const uint8* data, uint32 len) {
+        uint32 h = 2166136261u;
+        for (uint32 i = 0; i < len; i++) {
+            h = (h ^ data[i]) * 16777619u;
+        }
+        return h;
+    }
+
+    static uint32 _hashNickname(const uint8* nickname) {
+        return _hashBytes(nickname, QM_NICKNAME_LEN);
+    }
+
+    // Seeded multiply-xorshift over the four words of a content hash. Anyone
+    // can read the seed once it is drawn, but it changes every epoch, so
+    // colliding hashes cannot be prepared ahead of time or reused.
+    uint32 _hashContent(const uint8* contentHash) {
+        uint64 h = hashSeed;
+        for (uint32 i = 0; i < QM_HASH_LEN; i += 8) {
+            uint64 word;
+            QPI::memcpy(&word, contentHash + i, 8);
+            h = (h ^ word) * 0x9E3779B97F4A7C15ULL;
+            h ^= h >> 29;
+        }
+        return (uint32)(h ^ (h >> 32));
+    }
+
+    uint32* _indexTable(uint8 kind) {
+        if (kind == QM_INDEX_OWNER)    return ownerIndex;
+        if (kind == QM_INDEX_NICKNAME) return nicknameIndex;
+        if (kind == QM_INDEX_EXT)      return extIndex;
+        return hashIndex;
+    }
+
+    static uint32 _indexSize(uint8 kind) {
+        if (kind == QM_INDEX_EXT)     return QM_EXT_INDEX_SIZE;
+        if (kind == QM_INDEX_CONTENT) return QM_HASH_INDEX_SIZE;
+        return QM_USER_INDEX_SIZE;
+    }
+
+    // Hash of the key an index entry refers to, i.e. where its probe run starts
+    uint32 _indexKeyHash(uint8 kind, uint32 slot) {
+        if (kind == QM_INDEX_OWNER)    return _hashId(userOwner[slot]);
+        if (kind == QM_INDEX_NICKNAME) return _hashNickname(userNickname[slot]);
+        if (kind == QM_INDEX_EXT)      return _hashId(extIds[slot]);
+        return _hashContent(msgLog[slot].contentHash);
+    }
+
+    // Stores slot + 1 in the first free position of the probe sequence.
+    // Returns 0 if the QM_INDEX_MAX_PROBES window is exhausted.
+    uint8 _indexInsert(uint8 kind, uint32 hash, uint32 slot) {
+        uint32* table = _indexTable(kind);
+        uint32  size  = _indexSize(kind);
+        uint32  pos   = hash % size;
+        for (uint32 probe = 0; probe < QM_INDEX_MAX_PROBES; probe++) {
+            if (table[pos] == QM_INDEX_EMPTY || table[pos] == QM_INDEX_TOMBSTONE) {
+                table[pos] = slot + 1;
+                return 1;
+            }
+            pos = (pos + 1) % size;
+        }
+        return 0;
+    }
+
+    // Removes slot from the probe sequence starting at hash.
+    //
+    // Uses backward-shift deletion: later entries of the run that may live at
+    // the hole are pulled into it, so the ring's FIFO churn does not silt the
+    // content index up with tombstones. No entry sits QM_INDEX_MAX_PROBES or
+    // more past its home, so nothing that far past the hole can move into it.
+    // A tombstone is only left if QM_INDEX_SHIFT_BUDGET runs out first, which
+    // keeps the rest of a long run reachable.
+    void _indexErase(uint8 kind, uint32 hash, uint32 slot) {
+        uint32* table = _indexTable(kind);
+        uint32  size  = _indexSize(kind);
+        uint32  pos   = hash % size;
+        uint32  probe = 0;
+        while (table[pos] != slot + 1) {
+            if (table[pos] == QM_INDEX_EMPTY || ++probe >= QM_INDEX_MAX_PROBES) return;
+            pos = (pos + 1) % size;
+        }
+
+        uint32 hole = pos;
+        uint32 dist = 0;  // from hole to pos
+        for (uint32 step = 0; step < QM_INDEX_SHIFT_BUDGET; step++) {
+            pos = (pos + 1) % size;
+            dist++;
+            if (table[pos] == QM_INDEX_EMPTY || dist >= QM_INDEX_MAX_PROBES) {
+                table[hole] = QM_INDEX_EMPTY;
+                return;
+            }
+            if (table[pos] == QM_INDEX_TOMBSTONE) continue;
+            // Movable unless its home lies in (hole, pos]
+            uint32 home = _indexKeyHash(kind, table[pos] - 1) % size;
+            if ((pos + size - home) % size >= dist) {
+                table[hole] = table[pos];
+                hole = pos;
+                dist = 0;
+            }
+        }
+        table[hole] = QM_INDEX_TOMBSTONE;
+    }
+
+    // Returns 1 if seq is still held by the ring. The live window is the last
+    // min(msgSeq, QM_MSG_LOG_SIZE) seqs; unsigned wraparound pushes seq 0 and
+    // not-yet-posted seqs past the bound, so one comparison covers all cases.
+    uint8 _isLiveSeq(uint64 seq) {
+        uint64 live = msgSeq < QM_MSG_LOG_SIZE ? msgSeq : QM_MSG_LOG_SIZE;
+        return msgSeq - seq < live;
+    }
+
+    // Oldest seq still held by the ring (msgSeq + 1 when the log is empty)
+    uint64 _oldestLiveSeq() {
+        return msgSeq < QM_MSG_LOG_SIZE ? 1 : msgSeq - QM_MSG_LOG_SIZE + 1;
+    }
+
+    // Returns the extIds[] index holding value, or -1
+    sint32 _findExtId(const id& value) {
+        uint32 pos = _hashId(value) % QM_EXT_INDEX_SIZE;
+        for (uint32 probe = 0; probe < QM_INDEX_MAX_PROBES; probe++) {
+            uint32 ref = extIndex[pos];
+            if (ref == QM_INDEX_EMPTY) return -1;
+            if (ref != QM_INDEX_TOMBSTONE && extIds[ref - 1] == value) return (sint32)(ref - 1);
+            pos = (pos + 1) % QM_EXT_INDEX_SIZE;
+        }
+        return -1;
+    }
+
+    // Takes a log reference on receiver and returns its handle in ref.
+    // Returns 0 if receiver is unregistered and the extern table is full.
+    uint8 _acquireReceiverRef(const id& receiver, sint32 receiverSlot, uint32& ref) {
+        if (receiverSlot >= 0) {
+            userLogRefs[receiverSlot]++;
+            ref = (uint32)receiverSlot;
+            return 1;
+        }
+
+        sint32 ext = _findExtId(receiver);
+        if (ext < 0) {
+            if (extFreeCount == 0 && extCount >= QM_EXT_ID_SIZE) return 0;
+            uint32 fresh = extFreeCount > 0 ? extFree[extFreeCount - 1] : extCount;
+            if (!_indexInsert(QM_INDEX_EXT, _hashId(receiver), fresh)) return 0;
+            if (extFreeCount > 0) {
+                extFreeCount--;
+            } else {
+                extCount++;
+            }
+            extIds[fresh]  = receiver;
+            extRefs[fresh] = 0;
+            ext = (sint32)fresh;
+        }
+        extRefs[ext]++;
+        ref = QM_REF_EXTERNAL | (uint32)ext;
+        return 1;
+    }
+
+    static uint32 _refType(uint32 ref) {
+        return ref & QM_REF_TYPE_MASK;
+    }
+
+    // Drops one log reference, recycling handles that are no longer named
+    void _releaseRef(uint32 ref) {
+        if (_refType(ref) == QM_REF_BATCH_ROOT) return;
+        if (_refType(ref) == QM_REF_MULTICAST) {
+            for (uint32 i = 0; i < _mcastCount(ref); i++) {
+                _releaseRef(mcastSlots[(_mcastStart(ref) + i) % QM_MCAST_RING_SIZE]);
+            }
+            mcastTail += _mcastCount(ref);
+            return;
+        }
+        if (_refType(ref) == QM_REF_EXTERNAL) {
+            uint32 ext = ref & ~QM_REF_TYPE_MASK;
+            if (--extRefs[ext] == 0) {
+                _indexErase(QM_INDEX_EXT, _hashId(extIds[ext]), ext);
+                extFree[extFreeCount++] = ext;
+            }
+            return;
+        }
+        // Slots of deactivated users were held back from the free list until now
+        if (--userLogRefs[ref] == 0 && !_isActive(ref)) {
+            freeSlots[freeCount++] = ref;
+        }
+    }
+
+    // Receiver id of a direct entry; NULL_ID for multicast entries and batch roots
+    id _idOfRef(uint32 ref) {
+        if (_refType(ref) == 0) return userOwner[ref];
+        if (_refType(ref) == QM_REF_EXTERNAL) return extIds[ref & ~QM_REF_TYPE_MASK];
+        return NULL_ID;
+    }
+
+    static uint32 _batchLeafCount(uint32 ref) {
+        return _refType(ref) == QM_REF_BATCH_ROOT ? (ref & ~QM_REF_TYPE_MASK) : 0;
+    }
+
+    static uint8 _kindOfRef(uint32 ref) {
+        if (_refType(ref) == QM_REF_MULTICAST)  return QM_KIND_MULTICAST;
+        if (_refType(ref) == QM_REF_BATCH_ROOT) return QM_KIND_BATCH_ROOT;
+        return QM_KIND_DIRECT;
+    }
+
+    void _expandEntry(const QM_LogEntry& e, QM_MessageMeta& out) {
+        out.sender   = userOwner[e.senderSlot];
+        out.receiver = _idOfRef(e.receiverRef);
+        QPI::memcpy(out.contentHash, e.contentHash, QM_HASH_LEN);
+        out.tick     = e.tick;
+        out.nonce    = e.nonce;
+        out.seq      = e.seq;
+        out.kind     = _kindOfRef(e.receiverRef);
+        out.leafCount = _batchLeafCount(e.receiverRef);
+    }
+
+    static uint32 _mcastStart(uint32 ref) {
+        return ref & (QM_MCAST_RING_SIZE - 1);
+    }
+
+    static uint32 _mcastCount(uint32 ref) {
+        return (ref & ~QM_REF_TYPE_MASK) >> QM_MCAST_RING_BITS;
+    }
+
+    // Ring position of slot in the receiver run of a multicast entry, or -1
+    sint32 _mcastPosition(uint32 ref, uint32 slot) {
+        for (uint32 i = 0; i < _mcastCount(ref); i++) {
+            uint32 pos = (_mcastStart(ref) + i) % QM_MCAST_RING_SIZE;
+            if (mcastSlots[pos] == slot) return (sint32)pos;
+        }
+        return -1;
+    }
+
+    // Returns 1 if the live entry seq is addressed to user slot
+    uint8 _isInboxEntry(uint64 seq, uint32 slot) {
+        uint32 ref = msgLog[seq % QM_MSG_LOG_SIZE].receiverRef;
+        if (_refType(ref) == QM_REF_MULTICAST) return _mcastPosition(ref, slot) >= 0;
+        return ref == slot;
+    }
+
+    // Previous seq in slot's inbox chain before seq (an entry of that chain)
+    uint64 _inboxPrevOf(uint64 seq, uint32 slot) {
+        uint32 idx = (uint32)(seq % QM_MSG_LOG_SIZE);
+        uint32 ref = msgLog[idx].receiverRef;
+        if (_refType(ref) != QM_REF_MULTICAST) return inboxPrev[idx];
+        sint32 pos = _mcastPosition(ref, slot);
+        return pos >= 0 ? mcastPrev[pos] : 0;
+    }
+
+    // Returns the hashIndex[] position whose entry carries contentHash, or -1
+    sint32 _findHashIndexPos(const uint8* contentHash) {
+        uint32 pos = _hashContent(contentHash) % QM_HASH_INDEX_SIZE;
+        for (uint32 probe = 0; probe < QM_INDEX_MAX_PROBES; probe++) {
+            uint32 ref = hashIndex[pos];
+            if (ref == QM_INDEX_EMPTY) return -1;
+            if (ref != QM_INDEX_TOMBSTONE &&
+                QPI::memcmp(msgLog[ref - 1].contentHash, contentHash, QM_HASH_LEN) == 0) {
+                return (sint32)pos;
+            }
+            pos = (pos + 1) % QM_HASH_INDEX_SIZE;
+        }
+        return -1;
+    }
+
+    // Indexes the content hash of ring position idx. An entry whose probe
+    // window is full stays unindexed. The first live entry
+    // keeps the key, so re-posting someone else's public hash cannot take
+    // over their delivery proof; idx queues behind it instead.
+    void _indexContentHash(uint32 idx) {
+        hashNext[idx] = 0;
+        sint32 pos = _findHashIndexPos(msgLog[idx].contentHash);
+        if (pos >= 0) {
+            uint32 head = hashIndex[pos] - 1;
+            hashNext[hashTail[head]] = idx + 1;
+            hashTail[head] = idx;
+            return;
+        }
+        hashTail[idx] = idx;
+        _indexInsert(QM_INDEX_CONTENT, _hashContent(msgLog[idx].contentHash), idx);
+    }
+
+    // Drops ring position idx from the content index. Entries leave in seq
+    // order, so the indexed entry is always the first of its hash to go and
+    // the key passes to the next live one.
+    void _unindexContentHash(uint32 idx) {
+        sint32 pos = _findHashIndexPos(msgLog[idx].contentHash);
+        if (pos < 0 || hashIndex[pos] != idx + 1) return;
+        if (hashNext[idx] == 0) {
+            _indexErase(QM_INDEX_CONTENT, _hashContent(msgLog[idx].contentHash), idx);
+            return;
+        }
+        uint32 next = hashNext[idx] - 1;
+        hashIndex[pos] = next + 1;  // same key, same probe position
+        hashTail[next] = hashTail[idx];
+    }
+
+    // Draws this epoch's content index seed from the log root and rebuilds the
+    // index under it, oldest live entry first so every hash keeps its order
+    void _reseedContentIndex(const QpiContextFunctionCall& qpi) {
+        QM_MmrPair pair;
+        pair.left  = _mmrRoot(qpi);
+        pair.right = NULL_ID;
+        pair.right.u64._0 = qpi.epoch();
+        hashSeed      = qpi.K12(pair).u64._0 | 1;
+        hashSeedEpoch = qpi.epoch();
+
+        for (uint32 pos = 0; pos < QM_HASH_INDEX_SIZE; pos++) {
+            hashIndex[pos] = QM_INDEX_EMPTY;
+        }
+        for (uint64 seq = _oldestLiveSeq(); seq <= msgSeq; seq++) {
+            _indexContentHash((uint32)(seq % QM_MSG_LOG_SIZE));
+        }
+    }
+
+    // Releases everything that references the entry about to be overwritten
+    // at idx. Clears its seq, so a second call does nothing.
+    void _evictEntry(uint32 idx) {
+        if (msgLog[idx].seq == 0) return;
+        _releaseRef(msgLog[idx].senderSlot);
+        _releaseRef(msgLog[idx].receiverRef);
+        _unindexContentHash(idx);
+        msgLog[idx].seq = 0;
+    }
+
+    // Walks slot's inbox (or outbox) chain newest-first from seq until it
+    // reaches sinceSeq, an evicted entry or the page limit. Inbox pages show
+    // the reader as receiver of multicast entries.
+    void _readChain(uint64 seq, uint8 inbox, uint32 slot, uint64 sinceSeq, uint32 maxCount,
+                    QM_MessagePage& page) {
+        uint32 limit = maxCount < QM_RANGE_MAX ? maxCount : QM_RANGE_MAX;
+        while (seq > sinceSeq) {
+            if (!_isLiveSeq(seq)) {
+                page.truncated = 1;
+                return;
+            }
+            if (page.count == limit) {
+                page.nextBeforeSeq = page.count > 0 ? page.entries[page.count - 1].seq : 0;
+                return;
+            }
+            QM_MessageMeta& out = page.entries[page.count++];
+            _expandEntry(msgLog[seq % QM_MSG_LOG_SIZE], out);
+            if (inbox) {
+                if (out.kind == QM_KIND_MULTICAST) out.receiver = userOwner[slot];
+                seq = _inboxPrevOf(seq, slot);
+            } else {
+                seq = outboxPrev[seq % QM_MSG_LOG_SIZE];
+            }
+        }
+    }
+
+    id _mmrLeafHash(const QpiContextFunctionCall& qpi, const QM_LogEntry& e) {
+        QM_MmrLeaf leaf;
+        leaf.sender   = userOwner[e.senderSlot];
+        leaf.receiver = _idOfRef(e.receiverRef);
+        if (_refType(e.receiverRef) == QM_REF_MULTICAST) {
+            QM_MmrReceivers list;
+            for (uint32 i = 0; i < QM_MCAST_MAX_RECEIVERS; i++) {
+                list.receivers[i] = i < _mcastCount(e.receiverRef)
+                    ? userOwner[mcastSlots[(_mcastStart(e.receiverRef) + i) % QM_MCAST_RING_SIZE]]
+                    : NULL_ID;
+            }
+            leaf.receiver = qpi.K12(list);
+        }
+        QPI::memcpy(leaf.contentHash, e.contentHash, QM_HASH_LEN);
+        leaf.seq      = e.seq;
+        leaf.tick     = e.tick;
+        leaf.nonce    = e.nonce;
+        leaf.kind     = _kindOfRef(e.receiverRef);
+        leaf.aux      = _batchLeafCount(e.receiverRef);
+        return qpi.K12(leaf);
+    }
+
+    static uint64 _mmrNodeCapacity(uint32 height) {
+        return ((uint64)QM_MSG_LOG_SIZE >> height) + 4;
+    }
+
+    // Position of node k at height h. Ring h starts after the rings below it:
+    // sum of (QM_MSG_LOG_SIZE >> j) for j < h is (2L - 1) - ((2L - 1) >> h).
+    static uint32 _mmrNodeSlot(uint32 height, uint64 k) {
+        uint64 below = (2ULL * QM_MSG_LOG_SIZE - 1) - ((2ULL * QM_MSG_LOG_SIZE - 1) >> height);
+        return (uint32)(below + 4ULL * height + k % _mmrNodeCapacity(height));
+    }
+
+    // Returns 1 if node k at height h is complete and not yet overwritten
+    uint8 _mmrHasNode(uint32 height, uint64 k) {
+        uint64 complete = msgSeq >> height;
+        return k < complete && complete - k <= _mmrNodeCapacity(height);
+    }
+
+    // Adds the leaf for seq, merging equal-height peaks: O(log n) hashes
+    void _mmrAppend(const QpiContextFunctionCall& qpi, uint64 seq, const id& leaf) {
+        uint64 k = seq - 1;  // leaf index; its set low bits are the peaks to merge
+        uint32 height = 0;
+        QM_MmrPair pair;
+        pair.right = leaf;
+        mmrNodes[_mmrNodeSlot(0, k)] = leaf;
+        while ((k >> height) & 1) {
+            pair.left  = mmrPeaks[height];
+            pair.right = qpi.K12(pair);
+            height++;
+            mmrNodes[_mmrNodeSlot(height, k >> height)] = pair.right;
+        }
+        mmrPeaks[height] = pair.right;
+    }
+
+    // Files the segment that seq just completed. Its first entry is still in
+    // the ring because QM_SEGMENT_SIZE < QM_MSG_LOG_SIZE.
+    void _closeSegment(const QpiContextFunctionCall& qpi, uint64 seq) {
+        uint64 k = seq / QM_SEGMENT_SIZE - 1;
+        QM_Segment& seg = segments[k % QM_SEGMENT_TABLE_SIZE];
+        seg.root      = mmrNodes[_mmrNodeSlot(QM_SEGMENT_BITS, k)];
+        seg.firstSeq  = seq - QM_SEGMENT_SIZE + 1;
+        seg.firstTick = msgLog[seg.firstSeq % QM_MSG_LOG_SIZE].tick;
+        seg.lastTick  = msgLog[seq % QM_MSG_LOG_SIZE].tick;
+        seg.epoch     = qpi.epoch();
+    }
+
+    // Bags the peaks right to left: root = K12(tallest || K12(... || lowest))
+    id _mmrRoot(const QpiContextFunctionCall& qpi) {
+        id root = NULL_ID;
+        uint8 started = 0;
+        QM_MmrPair pair;
+        for (uint32 h = 0; h < QM_MMR_MAX_HEIGHT; h++) {
+            if (!((msgSeq >> h) & 1)) continue;
+            if (!started) {
+                root = mmrPeaks[h];
+                started = 1;
+                continue;
+            }
+            pair.left  = mmrPeaks[h];
+            pair.right = root;
+            root = qpi.K12(pair);
+        }
+        return root;
+    }
+
+    // Writes one entry into the ring and links it into the content index, the
+    // MMR and the sender's outbox. receiverRef must already hold its log
+    // reference; inbox links are the caller's. Returns the new seq.
+    uint64 _writeEntry(const QpiContextFunctionCall& qpi, uint32 senderSlot, uint32 receiverRef,
+                       const uint8* contentHash, uint32 nonce) {
+        if (hashSeed == 0 || hashSeedEpoch != qpi.epoch()) _reseedContentIndex(qpi);
+
+        // Write to ring buffer, evicting the entry it replaces
+        uint64 seq = ++msgSeq;
+        uint32 idx = (uint32)(seq % QM_MSG_LOG_SIZE);
+        _evictEntry(idx);
+        userLogRefs[senderSlot]++;
+        msgLog[idx].senderSlot  = senderSlot;
+        msgLog[idx].receiverRef = receiverRef;
+        QPI::memcpy(msgLog[idx].contentHash, contentHash, QM_HASH_LEN);
+        msgLog[idx].tick        = qpi.tick();
+        msgLog[idx].nonce       = nonce;
+        msgLog[idx].seq         = seq;
+        _indexContentHash(idx);
+        _mmrAppend(qpi, seq, _mmrLeafHash(qpi, msgLog[idx]));
+        if (seq % QM_SEGMENT_SIZE == 0) _closeSegment(qpi, seq);
+
+        outboxPrev[idx]        = outboxHead[senderSlot];
+        outboxHead[senderSlot] = seq;
+        inboxPrev[idx]         = 0;
+        return seq;
+    }
+
+    // Appends seq to the inbox chain of user slot; prev receives the old head
+    void _linkInbox(const QpiContextFunctionCall& qpi, uint32 slot, uint64 seq, uint64& prev) {
+        prev            = inboxHead[slot];
+        inboxHead[slot] = seq;
+        inboxCount[slot]++;
+        inboxLastTick[slot] = qpi.tick();
+    }
+
+    // Appends a direct entry from senderSlot. Nonce and rate-limit checks are
+    // the caller's. Returns the new seq, or 0 if receiver is unregistered and
+    // the extern table is full.
+    uint64 _appendEntry(const QpiContextFunctionCall& qpi, uint32 senderSlot, const id& receiver,
+                        const uint8* contentHash, uint32 nonce) {
+        sint32 receiverSlot = _findSlotByOwner(receiver);
+        uint32 receiverRef;
+        if (!_acquireReceiverRef(receiver, receiverSlot, receiverRef)) return 0;
+
+        uint64 seq = _writeEntry(qpi, senderSlot, receiverRef, contentHash, nonce);
+        if (receiverSlot >= 0) {
+            _linkInbox(qpi, (uint32)receiverSlot, seq, inboxPrev[seq % QM_MSG_LOG_SIZE]);
+        }
+        return seq;
+    }
+
+    // Opens a lane with nonce 0 counted as used
+    void _resetLane(uint32 slot, uint32 lane) {
+        nonceMax[slot][lane]    = 0;
+        nonceWindow[slot][lane] = 1;
+    }
+
+    // Returns 1 if nonce has not been used on slot's lane and is not older
+    // than its replay window
+    uint8 _isFreshNonce(uint32 slot, uint32 lane, uint32 nonce) {
+        if (nonce > nonceMax[slot][lane]) return 1;
+        uint32 age = nonceMax[slot][lane] - nonce;
+        if (age >= QM_NONCE_WINDOW) return 0;
+        return !((nonceWindow[slot][lane] >> age) & 1);
+    }
+
+    // Marks a fresh nonce as used, sliding the window forward if it is the new maximum
+    void _useNonce(uint32 slot, uint32 lane, uint32 nonce) {
+        if (nonce > nonceMax[slot][lane]) {
+            uint32 shift = nonce - nonceMax[slot][lane];
+            nonceWindow[slot][lane] = shift >= QM_NONCE_WINDOW ? 0 : nonceWindow[slot][lane] << shift;
+            nonceWindow[slot][lane] |= 1;
+            nonceMax[slot][lane] = nonce;
+            return;
+        }
+        nonceWindow[slot][lane] |= 1ULL << (nonceMax[slot][lane] - nonce);
+    }
+
+    uint32 _tierCapacity(uint8 tier) {
+        switch (tier) {
+            case QM_TIER_SILVER:  return QM_RATE_CAPACITY_SILVER;
+            case QM_TIER_GOLD:    return QM_RATE_CAPACITY_GOLD;
+            case QM_TIER_DIAMOND: return QM_RATE_CAPACITY_DIAMOND;
+            default:              return QM_RATE_CAPACITY_FREE;
+        }
+    }
+
+    uint32 _tierRefillTicks(uint8 tier) {
+        switch (tier) {
+            case QM_TIER_SILVER:  return QM_RATE_REFILL_TICKS_SILVER;
+            case QM_TIER_GOLD:    return QM_RATE_REFILL_TICKS_GOLD;
+            case QM_TIER_DIAMOND: return QM_RATE_REFILL_TICKS_DIAMOND;
+            default:              return QM_RATE_REFILL_TICKS_FREE;
+        }
+    }
+
+    // Re-reads the owner's balance and caches slot's tier for this epoch
+    void _refreshTier(const QpiContextFunctionCall& qpi, uint32 slot) {
+        Entity entity;
+        sint64 balance = 0;
+        if (qpi.getEntity(userOwner[slot], entity)) {
+            balance = entity.incomingAmount - entity.outgoingAmount;
+        }
+        if (balance >= QM_TIER_DIAMOND_MIN_BALANCE)     userTier[slot] = QM_TIER_DIAMOND;
+        else if (balance >= QM_TIER_GOLD_MIN_BALANCE)   userTier[slot] = QM_TIER_GOLD;
+        else if (balance >= QM_TIER_SILVER_MIN_BALANCE) userTier[slot] = QM_TIER_SILVER;
+        else                                            userTier[slot] = QM_TIER_FREE;
+        userTierEpoch[slot] = qpi.epoch();
+    }
+
+    // Credits the ticks since rateTick to slot's bucket and returns the tokens
+    // available. Called on every post, so a bucket that is full is always
+    // current when a token is spent. The balance is only queried on the first
+    // post of an epoch.
+    uint32 _refillTokens(const QpiContextFunctionCall& qpi, uint32 slot) {
+        if (userTierEpoch[slot] != qpi.epoch()) {
+            _refreshTier(qpi, slot);
+        }
+        uint32 capacity = _tierCapacity(userTier[slot]);
+        uint32 interval = _tierRefillTicks(userTier[slot]);
+        if (rateTokens[slot] > capacity) {
+            rateTokens[slot] = capacity;  // dropped to a lower tier
+        }
+
+        uint32 earned = (qpi.tick() - rateTick[slot]) / interval;
+        if (earned == 0) return rateTokens[slot];
+        if (earned >= capacity - rateTokens[slot]) {
+            rateTokens[slot] = capacity;
+            rateTick[slot]   = qpi.tick();
+        } else {
+            rateTokens[slot] += earned;
+            rateTick[slot]   += earned * interval;  // keep the partial interval
+        }
+        return rateTokens[slot];
+    }
+
     // Returns user slot index for a given owner id, or -1 if not found
     sint32 _findSlotByOwner(const id& owner) {
-        for (uint32 i = 0; i < userCount; i++) {
-            if (users[i].active && users[i].owner == owner) return (sint32)i;
+        uint32 pos = _hashId(owner) % QM_USER_INDEX_SIZE;
+        for (uint32 probe = 0; probe < QM_INDEX_MAX_PROBES; probe++) {
+            uint32 ref = ownerIndex[pos];
+            if (ref == QM_INDEX_EMPTY) return -1;
+            if (ref != QM_INDEX_TOMBSTONE && _isActive(ref - 1) && userOwner[ref - 1] == owner) {
+                return (sint32)(ref - 1);
+            }
+            pos = (pos + 1) % QM_USER_INDEX_SIZE;
         }
         return -1;
     }
 
     // Returns user slot index for a given nickname, or -1 if not found
     sint32 _findSlotByNickname(const uint8* nickname) {
-        for (uint32 i = 0; i < userCount; i++) {
-            if (users[i].active &&
-                QPI::memcmp(users[i].nickname, nickname, QM_NICKNAME_LEN) == 0) {
-                return (sint32)i;
+        uint32 pos = _hashNickname(nickname) % QM_USER_INDEX_SIZE;
+        for (uint32 probe = 0; probe < QM_INDEX_MAX_PROBES; probe++) {
+            uint32 ref = nicknameIndex[pos];
+            if (ref == QM_INDEX_EMPTY) return -1;
+            if (ref != QM_INDEX_TOMBSTONE && _isActive(ref - 1) &&
+                QPI::memcmp(userNickname[ref - 1], nickname, QM_NICKNAME_LEN) == 0) {
+                return (sint32)(ref - 1);
             }
+            pos = (pos + 1) % QM_USER_INDEX_SIZE;
         }
         return -1;
     }
@@ -88,7 +916,8 @@ struct QubicMessenger {
         uint8 pubkey[QM_PUBKEY_LEN];
     };
     struct RegisterUser_output {
-        sint32 slotIndex; // >= 0 on success, -1 taken, -2 registry full, -3 already registered
+        sint32 slotIndex; // >= 0 on success, -1 taken, -2 registry full, -3 already registered,
+                          // -4 index probe window full (try another nickname)
     };
 
     PUBLIC_PROCEDURE(RegisterUser)
@@ -107,21 +936,45 @@ struct QubicMessenger {
             return;
         }
 
-        // Check registry capacity
-        if (userCount >= QM_MAX_USERS) {
+        // Check registry capacity, preferring a reclaimed slot
+        if (freeCount == 0 && userCount >= QM_MAX_USERS) {
             output.slotIndex = -2;
             return;
         }
 
-        uint32 slot = userCount++;
-        QPI::memcpy(users[slot].nickname, input.nickname, QM_NICKNAME_LEN);
-        QPI::memcpy(users[slot].pubkey,   input.pubkey,   QM_PUBKEY_LEN);
-        users[slot].owner            = caller;
-        users[slot].registeredTick   = qpi.tick();
-        users[slot].lastUpdateTick   = qpi.tick();
-        users[slot].active           = 1;
-        lastNonce[slot]              = 0;
-        lastPostTick[slot]           = 0;
+        uint32 slot = freeCount > 0 ? freeSlots[freeCount - 1] : userCount;
+        // A full probe window is its own error: the registry may still have room
+        if (!_indexInsert(QM_INDEX_OWNER, _hashId(caller), slot)) {
+            output.slotIndex = -4;
+            return;
+        }
+        if (!_indexInsert(QM_INDEX_NICKNAME, _hashNickname(input.nickname), slot)) {
+            _indexErase(QM_INDEX_OWNER, _hashId(caller), slot);
+            output.slotIndex = -4;
+            return;
+        }
+        if (freeCount > 0) {
+            freeCount--;
+        } else {
+            userCount++;
+        }
+
+        QPI::memcpy(userNickname[slot], input.nickname, QM_NICKNAME_LEN);
+        QPI::memcpy(userPubkey[slot],   input.pubkey,   QM_PUBKEY_LEN);
+        userOwner[slot]              = caller;
+        userRegisteredTick[slot]     = qpi.tick();
+        userLastUpdateTick[slot]     = qpi.tick();
+        _setActive(slot, 1);
+        // A reclaimed slot must not inherit the previous owner's nonce, rate limit or inbox
+        _resetLane(slot, 0);
+        laneCount[slot]              = 1;
+        _refreshTier(qpi, slot);
+        rateTokens[slot]             = _tierCapacity(userTier[slot]);
+        rateTick[slot]               = qpi.tick();
+        inboxHead[slot]              = 0;
+        inboxCount[slot]             = 0;
+        inboxLastTick[slot]          = 0;
+        outboxHead[slot]             = 0;
 
         output.slotIndex = (sint32)slot;
     _
@@ -142,9 +995,9 @@ struct QubicMessenger {
         output.found = 0;
         sint32 slot = _findSlotByNickname(input.nickname);
         if (slot >= 0) {
-            QPI::memcpy(output.pubkey, users[slot].pubkey, QM_PUBKEY_LEN);
-            output.owner          = users[slot].owner;
-            output.registeredTick = users[slot].registeredTick;
+            QPI::memcpy(output.pubkey, userPubkey[slot], QM_PUBKEY_LEN);
+            output.owner          = userOwner[slot];
+            output.registeredTick = userRegisteredTick[slot];
             output.found          = 1;
         }
     _
@@ -164,8 +1017,8 @@ struct QubicMessenger {
         output.found = 0;
         sint32 slot = _findSlotByOwner(input.owner);
         if (slot >= 0) {
-            QPI::memcpy(output.nickname, users[slot].nickname, QM_NICKNAME_LEN);
-            QPI::memcpy(output.pubkey,   users[slot].pubkey,   QM_PUBKEY_LEN);
+            QPI::memcpy(output.nickname, userNickname[slot], QM_NICKNAME_LEN);
+            QPI::memcpy(output.pubkey,   userPubkey[slot],   QM_PUBKEY_LEN);
             output.found = 1;
         }
     _
@@ -185,8 +1038,8 @@ struct QubicMessenger {
             output.success = 0;
             return;
         }
-        QPI::memcpy(users[slot].pubkey, input.newPubkey, QM_PUBKEY_LEN);
-        users[slot].lastUpdateTick = qpi.tick();
+        QPI::memcpy(userPubkey[slot], input.newPubkey, QM_PUBKEY_LEN);
+        userLastUpdateTick[slot] = qpi.tick();
         output.success = 1;
     _
 
@@ -205,21 +1058,64 @@ struct QubicMessenger {
             output.success = 0;
             return;
         }
-        users[slot].active = 0;
+        _setActive((uint32)slot, 0);
+        // Dropping both keys frees the nickname for a new registration
+        _indexErase(QM_INDEX_OWNER,    _hashId(userOwner[slot]),          (uint32)slot);
+        _indexErase(QM_INDEX_NICKNAME, _hashNickname(userNickname[slot]), (uint32)slot);
+        // Slots still named by live log entries are recycled by _releaseRef
+        if (userLogRefs[slot] == 0) {
+            freeSlots[freeCount++] = (uint32)slot;
+        }
         output.success = 1;
     _
 
+    // ── Procedure: AddDeviceLane ──────────────────────────────────────────────
+
+    struct AddDeviceLane_input {
+        // no fields — caller is implicitly the user
+    };
+    struct AddDeviceLane_output {
+        uint8  lane;      // pass as the lane of every post made from the new device
+        uint8  success;
+        uint8  errorCode; // 0=ok, 1=not registered, 9=all QM_MAX_LANES lanes in use
+    };
+
+    // Opens a nonce lane for another device, so it can post without
+    // coordinating nonces with the user's other devices
+    PUBLIC_PROCEDURE(AddDeviceLane)
+        output.success = 0;
+
+        sint32 slot = _findSlotByOwner(qpi.invocator());
+        if (slot < 0) {
+            output.errorCode = 1;
+            return;
+        }
+
+        if (laneCount[slot] >= QM_MAX_LANES) {
+            output.errorCode = 9;
+            return;
+        }
+
+        output.lane = laneCount[slot]++;
+        _resetLane((uint32)slot, output.lane);
+        output.success   = 1;
+        output.errorCode = 0;
+    _
+
     // ── Procedure: PostMessageMeta ────────────────────────────────────────────
 
     struct PostMessageMeta_input {
         id     receiver;
         uint8  contentHash[QM_HASH_LEN];
         uint32 nonce;
+        uint8  lane;      // device lane the nonce belongs to (0 unless AddDeviceLane was used)
     };
     struct PostMessageMeta_output {
         uint8  success;
-        uint8  errorCode; // 0=ok, 1=not registered, 2=bad nonce, 3=rate limited, 4=self-message
+        uint8  errorCode; // 0=ok, 1=not registered, 2=bad nonce, 3=rate limited, 4=self-message,
+                          // 5=receiver table full (unregistered receiver), 9=unknown lane
         uint32 logIndex;
+        uint64 seq;       // pass to GetMessageMetaBySeq; stays unambiguous after the ring wraps
     };
 
     PUBLIC_PROCEDURE(PostMessageMeta)
@@ -239,34 +1135,280 @@ struct QubicMessenger {
             return;
         }
 
-        // Nonce must strictly increase
-        if (input.nonce <= lastNonce[senderSlot]) {
+        // Nonce must be unused and inside the lane's replay window
+        if (input.lane >= laneCount[senderSlot]) {
+            output.errorCode = 9;
+            return;
+        }
+
+        if (!_isFreshNonce((uint32)senderSlot, input.lane, input.nonce)) {
             output.errorCode = 2;
             return;
         }
 
-        // Rate limit: max 1 metadata post per 10 ticks (~10 seconds)
-        if (lastPostTick[senderSlot] != 0 &&
-            qpi.tick() - lastPostTick[senderSlot] < 10) {
+        // Rate limit: token bucket sized by the sender's balance tier
+        if (_refillTokens(qpi, (uint32)senderSlot) == 0) {
             output.errorCode = 3;
             return;
         }
 
-        lastNonce[senderSlot]    = input.nonce;
-        lastPostTick[senderSlot] = qpi.tick();
+        uint64 seq = _appendEntry(qpi, (uint32)senderSlot, input.receiver, input.contentHash, input.nonce);
+        if (seq == 0) {
+            output.errorCode = 5;
+            return;
+        }
 
-        // Write to ring buffer
-        uint32 idx = msgHead % QM_MSG_LOG_SIZE;
-        msgLog[idx].sender   = caller;
-        msgLog[idx].receiver = input.receiver;
-        QPI::memcpy(msgLog[idx].contentHash, input.contentHash, QM_HASH_LEN);
-        msgLog[idx].tick     = qpi.tick();
-        msgLog[idx].nonce    = input.nonce;
-        msgHead++;
+        _useNonce((uint32)senderSlot, input.lane, input.nonce);
+        rateTokens[senderSlot]--;
 
         output.success  = 1;
         output.errorCode = 0;
-        output.logIndex  = idx;
+        output.logIndex  = (uint32)(seq % QM_MSG_LOG_SIZE);
+        output.seq       = seq;
+    _
+
+    // ── Procedure: PostMessageMetaBatch ───────────────────────────────────────
+
+    // Columns rather than an array of tuples: QM_BATCH_MAX entries then fill
+    // the 1024-byte transaction input with no padding between them.
+    struct PostMessageMetaBatch_input {
+        id     receivers[QM_BATCH_MAX];
+        uint8  contentHashes[QM_BATCH_MAX][QM_HASH_LEN];
+        uint32 nonces[QM_BATCH_MAX];  // each unused and inside the lane's replay window
+        uint8  count;
+        uint8  lane;
+    };
+    struct PostMessageMetaBatch_output {
+        uint64 seqs[QM_BATCH_MAX];        // 0 where the entry was rejected
+        uint8  entryErrors[QM_BATCH_MAX]; // per entry: 0=ok, 2=bad nonce, 4=self-message,
+                                          // 5=receiver table full
+        uint8  accepted;                  // entries written
+        uint8  errorCode;                 // whole batch: 0=ok, 1=not registered,
+                                          // 3=rate limited, 6=bad count, 9=unknown lane
+    };
+
+    // One owner lookup and one rate-limit token for up to QM_BATCH_MAX receipts,
+    // e.g. a group message fanned out to every member
+    PUBLIC_PROCEDURE(PostMessageMetaBatch)
+        id caller = qpi.invocator();
+        output.accepted = 0;
+
+        sint32 senderSlot = _findSlotByOwner(caller);
+        if (senderSlot < 0) {
+            output.errorCode = 1;
+            return;
+        }
+
+        if (input.count == 0 || input.count > QM_BATCH_MAX) {
+            output.errorCode = 6;
+            return;
+        }
+
+        if (input.lane >= laneCount[senderSlot]) {
+            output.errorCode = 9;
+            return;
+        }
+
+        if (_refillTokens(qpi, (uint32)senderSlot) == 0) {
+            output.errorCode = 3;
+            return;
+        }
+
+        for (uint32 i = 0; i < input.count; i++) {
+            output.seqs[i] = 0;
+            if (caller == input.receivers[i]) {
+                output.entryErrors[i] = 4;
+                continue;
+            }
+            // Marked only once accepted, so a rejected entry does not burn its
+            // nonce, while a nonce repeated within the batch is caught
+            if (!_isFreshNonce((uint32)senderSlot, input.lane, input.nonces[i])) {
+                output.entryErrors[i] = 2;
+                continue;
+            }
+            uint64 seq = _appendEntry(qpi, (uint32)senderSlot, input.receivers[i],
+                                      input.contentHashes[i], input.nonces[i]);
+            if (seq == 0) {
+                output.entryErrors[i] = 5;
+                continue;
+            }
+            _useNonce((uint32)senderSlot, input.lane, input.nonces[i]);
+            output.seqs[i]        = seq;
+            output.entryErrors[i] = 0;
+            output.accepted++;
+        }
+
+        if (output.accepted > 0) rateTokens[senderSlot]--;
+        output.errorCode = 0;
+    _
+
+    // ── Procedure: PostMulticastMeta ──────────────────────────────────────────
+
+    struct PostMulticastMeta_input {
+        id     receivers[QM_MCAST_MAX_RECEIVERS];
+        uint8  contentHash[QM_HASH_LEN];
+        uint32 nonce;
+        uint8  count;
+        uint8  lane;
+    };
+    struct PostMulticastMeta_output {
+        uint64 seq;
+        uint32 skippedMask;  // bit i: receivers[i] unregistered, the sender, or a duplicate
+        uint8  linked;       // receivers whose inbox got the entry
+        uint8  success;
+        uint8  errorCode;    // 0=ok, 1=not registered, 2=bad nonce, 3=rate limited,
+                             // 6=bad count, 7=no registered receivers, 9=unknown lane
+        uint8  fanout;       // 1 if the receiver ring was full: seq is the first of
+                             // `linked` consecutive direct entries, one per receiver
+    };
+
+    // One log entry for a message every receiver gets the same ciphertext of,
+    // e.g. a group message. Only registered receivers can be named, since the
+    // entry is reached through their inbox chains.
+    PUBLIC_PROCEDURE(PostMulticastMeta)
+        id caller = qpi.invocator();
+        output.success     = 0;
+        output.linked      = 0;
+        output.skippedMask = 0;
+        output.fanout      = 0;
+
+        sint32 senderSlot = _findSlotByOwner(caller);
+        if (senderSlot < 0) {
+            output.errorCode = 1;
+            return;
+        }
+
+        if (input.count == 0 || input.count > QM_MCAST_MAX_RECEIVERS) {
+            output.errorCode = 6;
+            return;
+        }
+
+        if (input.lane >= laneCount[senderSlot]) {
+            output.errorCode = 9;
+            return;
+        }
+
+        if (!_isFreshNonce((uint32)senderSlot, input.lane, input.nonce)) {
+            output.errorCode = 2;
+            return;
+        }
+
+        if (_refillTokens(qpi, (uint32)senderSlot) == 0) {
+            output.errorCode = 3;
+            return;
+        }
+
+        uint32 slots[QM_MCAST_MAX_RECEIVERS];
+        uint32 count = 0;
+        for (uint32 i = 0; i < input.count; i++) {
+            sint32 slot = _findSlotByOwner(input.receivers[i]);
+            uint8 duplicate = 0;
+            for (uint32 j = 0; j < count; j++) {
+                if (slots[j] == (uint32)slot) duplicate = 1;
+            }
+            if (slot < 0 || slot == senderSlot || duplicate) {
+                output.skippedMask |= 1U << i;
+                continue;
+            }
+            slots[count++] = (uint32)slot;
+        }
+        if (count == 0) {
+            output.errorCode = 7;
+            return;
+        }
+
+        _useNonce((uint32)senderSlot, input.lane, input.nonce);
+        rateTokens[senderSlot]--;
+        output.linked    = (uint8)count;
+        output.success   = 1;
+        output.errorCode = 0;
+
+        // Evict first so the outgoing entry's receiver run counts as free
+        _evictEntry((uint32)((msgSeq + 1) % QM_MSG_LOG_SIZE));
+        if (count > QM_MCAST_RING_SIZE - (mcastHead - mcastTail)) {
+            output.fanout = 1;
+            for (uint32 i = 0; i < count; i++) {
+                uint64 direct = _appendEntry(qpi, (uint32)senderSlot, userOwner[slots[i]],
+                                             input.contentHash, input.nonce);
+                if (i == 0) output.seq = direct;
+            }
+            return;
+        }
+
+        uint32 start = (uint32)(mcastHead % QM_MCAST_RING_SIZE);
+        for (uint32 i = 0; i < count; i++) {
+            mcastSlots[(start + i) % QM_MCAST_RING_SIZE] = slots[i];
+            userLogRefs[slots[i]]++;
+        }
+        mcastHead += count;
+
+        uint32 receiverRef = QM_REF_MULTICAST | (count << QM_MCAST_RING_BITS) | start;
+        uint64 seq = _writeEntry(qpi, (uint32)senderSlot, receiverRef, input.contentHash, input.nonce);
+        for (uint32 i = 0; i < count; i++) {
+            uint32 pos = (start + i) % QM_MCAST_RING_SIZE;
+            _linkInbox(qpi, mcastSlots[pos], seq, mcastPrev[pos]);
+        }
+        output.seq = seq;
+    _
+
+    // ── Procedure: PostBatchRoot ──────────────────────────────────────────────
+
+    struct PostBatchRoot_input {
+        uint8  root[QM_HASH_LEN];  // Merkle root over the batch leaves, see VerifyBatchLeaf
+        uint32 leafCount;
+        uint32 nonce;
+        uint8  lane;
+    };
+    struct PostBatchRoot_output {
+        uint8  success;
+        uint8  errorCode; // 0=ok, 1=not registered, 2=bad nonce, 3=rate limited, 6=bad count,
+                          // 9=unknown lane
+        uint32 logIndex;
+        uint64 seq;       // pass as rootSeq to VerifyBatchLeaf
+    };
+
+    // One log entry standing for up to 2^QM_BATCH_TREE_DEPTH receipts. The
+    // sender keeps the leaves and hands each receiver its Merkle path.
+    PUBLIC_PROCEDURE(PostBatchRoot)
+        id caller = qpi.invocator();
+        output.success = 0;
+
+        sint32 senderSlot = _findSlotByOwner(caller);
+        if (senderSlot < 0) {
+            output.errorCode = 1;
+            return;
+        }
+
+        if (input.leafCount == 0 || input.leafCount > (1U << QM_BATCH_TREE_DEPTH)) {
+            output.errorCode = 6;
+            return;
+        }
+
+        if (input.lane >= laneCount[senderSlot]) {
+            output.errorCode = 9;
+            return;
+        }
+
+        if (!_isFreshNonce((uint32)senderSlot, input.lane, input.nonce)) {
+            output.errorCode = 2;
+            return;
+        }
+
+        if (_refillTokens(qpi, (uint32)senderSlot) == 0) {
+            output.errorCode = 3;
+            return;
+        }
+
+        _useNonce((uint32)senderSlot, input.lane, input.nonce);
+        rateTokens[senderSlot]--;
+
+        uint64 seq = _writeEntry(qpi, (uint32)senderSlot, QM_REF_BATCH_ROOT | input.leafCount,
+                                 input.root, input.nonce);
+
+        output.success   = 1;
+        output.errorCode = 0;
+        output.logIndex  = (uint32)(seq % QM_MSG_LOG_SIZE);
+        output.seq       = seq;
     _
 
     // ── Function: GetMessageMeta ──────────────────────────────────────────────
@@ -280,34 +1422,493 @@ struct QubicMessenger {
         uint8  contentHash[QM_HASH_LEN];
         uint32 tick;
         uint32 nonce;
-        uint8  valid; // 1 if index is within current ring buffer window
+        uint8  valid; // 1 if the ring slot has been written
+        uint64 seq;   // seq currently held by the slot; compare to detect overwrites
+        uint8  kind;  // QM_KIND_*
     };
 
     PUBLIC_FUNCTION(GetMessageMeta)
         output.valid = 0;
         if (input.logIndex >= QM_MSG_LOG_SIZE) return;
-        // Valid if within the last QM_MSG_LOG_SIZE writes
-        if (msgHead > QM_MSG_LOG_SIZE &&
-            input.logIndex < (msgHead - QM_MSG_LOG_SIZE) % QM_MSG_LOG_SIZE) return;
-
-        QM_MessageMeta& m = msgLog[input.logIndex];
-        output.sender   = m.sender;
-        output.receiver = m.receiver;
-        QPI::memcpy(output.contentHash, m.contentHash, QM_HASH_LEN);
-        output.tick     = m.tick;
-        output.nonce    = m.nonce;
+
+        QM_LogEntry& e = msgLog[input.logIndex];
+        if (e.seq == 0) return;
+        output.sender   = userOwner[e.senderSlot];
+        output.receiver = _idOfRef(e.receiverRef);
+        QPI::memcpy(output.contentHash, e.contentHash, QM_HASH_LEN);
+        output.tick     = e.tick;
+        output.nonce    = e.nonce;
+        output.seq      = e.seq;
+        output.kind     = _kindOfRef(e.receiverRef);
         output.valid    = 1;
     _
 
+    // ── Function: GetMessageMetaBySeq ─────────────────────────────────────────
+
+    struct GetMessageMetaBySeq_input {
+        uint64 seq;
+    };
+    struct GetMessageMetaBySeq_output {
+        id     sender;
+        id     receiver;
+        uint8  contentHash[QM_HASH_LEN];
+        uint32 tick;
+        uint32 nonce;
+        uint8  valid; // 1 if seq has been posted and not yet overwritten
+        uint8  kind;  // QM_KIND_*
+        uint32 leafCount; // batch roots only
+    };
+
+    PUBLIC_FUNCTION(GetMessageMetaBySeq)
+        output.valid = 0;
+        if (!_isLiveSeq(input.seq)) return;
+
+        QM_LogEntry& e = msgLog[input.seq % QM_MSG_LOG_SIZE];
+        output.sender   = userOwner[e.senderSlot];
+        output.receiver = _idOfRef(e.receiverRef);
+        QPI::memcpy(output.contentHash, e.contentHash, QM_HASH_LEN);
+        output.tick     = e.tick;
+        output.nonce    = e.nonce;
+        output.kind     = _kindOfRef(e.receiverRef);
+        output.leafCount = _batchLeafCount(e.receiverRef);
+        output.valid    = 1;
+    _
+
+    // ── Function: GetMessageMetaRange ─────────────────────────────────────────
+
+    struct GetMessageMetaRange_input {
+        uint64 startSeq;  // 0 is read as 1 (start of history)
+        uint32 count;     // clamped to QM_RANGE_MAX
+    };
+    struct GetMessageMetaRange_output {
+        QM_MessageMeta entries[QM_RANGE_MAX];
+        uint64 nextSeq;   // pass as startSeq to continue; msgSeq + 1 once caught up
+        uint64 evicted;   // seqs from startSeq that were already overwritten and skipped
+        uint32 count;     // entries filled
+    };
+
+    PUBLIC_FUNCTION(GetMessageMetaRange)
+        uint64 seq    = input.startSeq == 0 ? 1 : input.startSeq;
+        uint64 oldest = _oldestLiveSeq();
+        output.evicted = 0;
+        if (seq < oldest) {
+            output.evicted = oldest - seq;
+            seq = oldest;
+        }
+
+        uint32 limit = input.count < QM_RANGE_MAX ? input.count : QM_RANGE_MAX;
+        output.count = 0;
+        while (output.count < limit && seq <= msgSeq) {
+            _expandEntry(msgLog[seq % QM_MSG_LOG_SIZE], output.entries[output.count++]);
+            seq++;
+        }
+        output.nextSeq = seq;
+    _
+
+    // ── Function: GetInbox ────────────────────────────────────────────────────
+
+    struct GetInbox_input {
+        id     receiver;
+        uint64 sinceSeq;   // return only entries with seq > sinceSeq
+        uint64 beforeSeq;  // 0 = start at the newest entry, else resume below this seq
+        uint32 maxCount;   // clamped to QM_RANGE_MAX
+    };
+    typedef QM_MessagePage GetInbox_output;
+
+    PUBLIC_FUNCTION(GetInbox)
+        output.count         = 0;
+        output.nextBeforeSeq = 0;
+        output.truncated     = 0;
+
+        sint32 slot = _findSlotByOwner(input.receiver);
+        if (slot < 0) return;
+
+        uint64 seq = inboxHead[slot];
+        if (input.beforeSeq != 0) {
+            // The cursor must still be a live entry of this receiver
+            if (!_isLiveSeq(input.beforeSeq) || !_isInboxEntry(input.beforeSeq, (uint32)slot)) {
+                output.truncated = 1;
+                return;
+            }
+            seq = _inboxPrevOf(input.beforeSeq, (uint32)slot);
+        }
+
+        _readChain(seq, 1, (uint32)slot, input.sinceSeq, input.maxCount, output);
+    _
+
+    // ── Function: GetInboxHead ────────────────────────────────────────────────
+
+    struct GetInboxHead_input {
+        id receiver;
+    };
+    struct GetInboxHead_output {
+        uint64 latestSeq;   // newest inbound seq, 0 = none
+        uint32 totalCount;  // inbound entries since registration
+        uint32 lastTick;    // tick of the newest inbound entry
+        uint8  found;       // 0 if receiver is not registered
+    };
+
+    // Cheap polling watermark: fetch the inbox only when latestSeq moves
+    PUBLIC_FUNCTION(GetInboxHead)
+        output.found = 0;
+        sint32 slot = _findSlotByOwner(input.receiver);
+        if (slot < 0) return;
+        output.latestSeq  = inboxHead[slot];
+        output.totalCount = inboxCount[slot];
+        output.lastTick   = inboxLastTick[slot];
+        output.found      = 1;
+    _
+
+    // ── Function: GetOutbox ───────────────────────────────────────────────────
+
+    struct GetOutbox_input {
+        id     sender;
+        uint64 sinceSeq;   // return only entries with seq > sinceSeq
+        uint64 beforeSeq;  // 0 = start at the newest entry, else resume below this seq
+        uint32 maxCount;   // clamped to QM_RANGE_MAX
+    };
+    typedef QM_MessagePage GetOutbox_output;
+
+    PUBLIC_FUNCTION(GetOutbox)
+        output.count         = 0;
+        output.nextBeforeSeq = 0;
+        output.truncated     = 0;
+
+        sint32 slot = _findSlotByOwner(input.sender);
+        if (slot < 0) return;
+
+        uint64 seq = outboxHead[slot];
+        if (input.beforeSeq != 0) {
+            if (!_isLiveSeq(input.beforeSeq) ||
+                msgLog[input.beforeSeq % QM_MSG_LOG_SIZE].senderSlot != (uint32)slot) {
+                output.truncated = 1;
+                return;
+            }
+            seq = outboxPrev[input.beforeSeq % QM_MSG_LOG_SIZE];
+        }
+
+        _readChain(seq, 0, (uint32)slot, input.sinceSeq, input.maxCount, output);
+    _
+
+    // ── Function: GetMessagesByTickRange ───────────────────────────────────────
+
+    struct GetMessagesByTickRange_input {
+        uint32 fromTick;   // inclusive
+        uint32 toTick;     // inclusive
+        uint64 startSeq;   // 0 = search for fromTick, else resume at a previous nextSeq
+    };
+    struct GetMessagesByTickRange_output {
+        QM_MessageMeta entries[QM_RANGE_MAX];  // oldest first
+        uint64 nextSeq;    // non-zero if more entries in range remain: pass as startSeq
+        uint32 count;
+        uint8  evicted;    // 1 if entries at the start of the range may already be overwritten
+    };
+
+    // Ticks are appended in non-decreasing order, so the live window is its own
+    // sorted tick index: a binary search finds the first seq, then reads are
+    // contiguous.
+    PUBLIC_FUNCTION(GetMessagesByTickRange)
+        output.count   = 0;
+        output.nextSeq = 0;
+        output.evicted = 0;
+
+        uint64 oldest = _oldestLiveSeq();
+        uint64 seq    = input.startSeq;
+        if (seq == 0) {
+            uint64 lo = oldest;
+            uint64 hi = msgSeq + 1;
+            while (lo < hi) {
+                uint64 mid = lo + (hi - lo) / 2;
+                if (msgLog[mid % QM_MSG_LOG_SIZE].tick < input.fromTick) lo = mid + 1;
+                else hi = mid;
+            }
+            seq = lo;
+            // Anything before the oldest live entry could have been in range
+            output.evicted = oldest > 1 && seq == oldest ? 1 : 0;
+        } else if (seq < oldest) {
+            seq = oldest;
+            output.evicted = 1;
+        }
+
+        while (seq <= msgSeq && msgLog[seq % QM_MSG_LOG_SIZE].tick <= input.toTick) {
+            if (output.count == QM_RANGE_MAX) {
+                output.nextSeq = seq;
+                break;
+            }
+            _expandEntry(msgLog[seq % QM_MSG_LOG_SIZE], output.entries[output.count++]);
+            seq++;
+        }
+    _
+
+    // ── Function: VerifyDelivery ──────────────────────────────────────────────
+
+    struct VerifyDelivery_input {
+        uint8 contentHash[QM_HASH_LEN];
+        id    sender;    // NULL_ID = any sender
+        id    receiver;  // NULL_ID = any receiver; batch roots only match NULL_ID
+    };
+    struct VerifyDelivery_output {
+        id     sender;
+        id     receiver;  // for multicast entries, the requested receiver (NULL_ID if any)
+        uint64 seq;
+        uint32 tick;
+        uint32 nonce;
+        uint8  found;      // 1 if a live entry matches (the oldest one is returned)
+        uint8  kind;       // QM_KIND_*
+        uint8  truncated;  // 1 if QM_DELIVERY_MAX_WALK entries were checked without a match
+    };
+
+    // Delivery proof lookup through the content-hash index, then along the
+    // entries sharing that hash until sender and receiver match
+    PUBLIC_FUNCTION(VerifyDelivery)
+        output.found     = 0;
+        output.truncated = 0;
+        sint32 pos = _findHashIndexPos(input.contentHash);
+        if (pos < 0) return;
+
+        uint32 idx = hashIndex[pos] - 1;
+        for (uint32 walked = 0; walked < QM_DELIVERY_MAX_WALK; walked++) {
+            QM_LogEntry& e = msgLog[idx];
+            uint8 match = input.sender == NULL_ID || userOwner[e.senderSlot] == input.sender;
+            if (match && input.receiver != NULL_ID) {
+                if (_refType(e.receiverRef) == QM_REF_MULTICAST) {
+                    match = 0;
+                    for (uint32 i = 0; i < _mcastCount(e.receiverRef); i++) {
+                        uint32 slot = mcastSlots[(_mcastStart(e.receiverRef) + i) % QM_MCAST_RING_SIZE];
+                        if (userOwner[slot] == input.receiver) match = 1;
+                    }
+                } else {
+                    match = _refType(e.receiverRef) != QM_REF_BATCH_ROOT && _idOfRef(e.receiverRef) == input.receiver;
+                }
+            }
+            if (match) {
+                output.sender   = userOwner[e.senderSlot];
+                output.receiver = input.receiver != NULL_ID ? input.receiver : _idOfRef(e.receiverRef);
+                output.seq      = e.seq;
+                output.tick     = e.tick;
+                output.nonce    = e.nonce;
+                output.kind     = _kindOfRef(e.receiverRef);
+                output.found    = 1;
+                return;
+            }
+            if (hashNext[idx] == 0) return;
+            idx = hashNext[idx] - 1;
+        }
+        output.truncated = 1;
+    _
+
+    // ── Function: GetMulticastReceivers ───────────────────────────────────────
+
+    struct GetMulticastReceivers_input {
+        uint64 seq;
+    };
+    struct GetMulticastReceivers_output {
+        id     receivers[QM_MCAST_MAX_RECEIVERS];  // hashed in this order into the MMR leaf
+        uint32 count;
+        uint8  found;  // 0 if seq is evicted or not a multicast entry
+    };
+
+    PUBLIC_FUNCTION(GetMulticastReceivers)
+        output.found = 0;
+        output.count = 0;
+        if (!_isLiveSeq(input.seq)) return;
+
+        uint32 ref = msgLog[input.seq % QM_MSG_LOG_SIZE].receiverRef;
+        if (_refType(ref) != QM_REF_MULTICAST) return;
+        for (uint32 i = 0; i < _mcastCount(ref); i++) {
+            output.receivers[i] = userOwner[mcastSlots[(_mcastStart(ref) + i) % QM_MCAST_RING_SIZE]];
+        }
+        output.count = _mcastCount(ref);
+        output.found = 1;
+    _
+
+    // ── Function: VerifyBatchLeaf ─────────────────────────────────────────────
+
+    struct VerifyBatchLeaf_input {
+        id     path[QM_BATCH_TREE_DEPTH];  // siblings leaf upwards; only the first depth are read
+        id     receiver;
+        uint8  contentHash[QM_HASH_LEN];
+        uint64 rootSeq;    // seq of the PostBatchRoot entry
+        uint32 leafIndex;
+        uint32 nonce;
+    };
+    struct VerifyBatchLeaf_output {
+        id     sender;     // who posted the root
+        uint32 tick;
+        uint32 leafCount;
+        uint8  valid;      // 1 if the leaf hashes up to the stored root
+        uint8  errorCode;  // 0=ok, 1=rootSeq evicted or not a batch root, 2=leafIndex out of range,
+                           // 3=path mismatch
+    };
+
+    // Depth is ceil(log2(leafCount)); a leaf is K12(QM_BatchLeaf) and each
+    // level hashes QM_MmrPair { left, right }, exactly like the log MMR
+    PUBLIC_FUNCTION(VerifyBatchLeaf)
+        output.valid = 0;
+        if (!_isLiveSeq(input.rootSeq) ||
+            _refType(msgLog[input.rootSeq % QM_MSG_LOG_SIZE].receiverRef) != QM_REF_BATCH_ROOT) {
+            output.errorCode = 1;
+            return;
+        }
+
+        QM_LogEntry& e = msgLog[input.rootSeq % QM_MSG_LOG_SIZE];
+        output.sender    = userOwner[e.senderSlot];
+        output.tick      = e.tick;
+        output.leafCount = _batchLeafCount(e.receiverRef);
+        if (input.leafIndex >= output.leafCount) {
+            output.errorCode = 2;
+            return;
+        }
+
+        QM_BatchLeaf leaf;
+        leaf.receiver = input.receiver;
+        QPI::memcpy(leaf.contentHash, input.contentHash, QM_HASH_LEN);
+        leaf.nonce = input.nonce;
+        for (uint32 i = 0; i < 7; i++) leaf.reserved[i] = 0;
+
+        QM_MmrPair pair;
+        id node = qpi.K12(leaf);
+        for (uint32 h = 0; h < QM_BATCH_TREE_DEPTH && (1U << h) < output.leafCount; h++) {
+            if ((input.leafIndex >> h) & 1) {
+                pair.left  = input.path[h];
+                pair.right = node;
+            } else {
+                pair.left  = node;
+                pair.right = input.path[h];
+            }
+            node = qpi.K12(pair);
+        }
+
+        if (QPI::memcmp(node.m256i_u8, e.contentHash, QM_HASH_LEN) != 0) {
+            output.errorCode = 3;
+            return;
+        }
+        output.valid     = 1;
+        output.errorCode = 0;
+    _
+
+    // ── Function: GetLogRoot ──────────────────────────────────────────────────
+
+    struct GetLogRoot_input {
+        // no fields
+    };
+    struct GetLogRoot_output {
+        id     root;       // NULL_ID while the log is empty
+        uint64 leafCount;  // entries committed to, i.e. the newest seq
+    };
+
+    PUBLIC_FUNCTION(GetLogRoot)
+        output.root      = _mmrRoot(qpi);
+        output.leafCount = msgSeq;
+    _
+
+    // ── Function: GetInclusionProof ───────────────────────────────────────────
+
+    struct GetInclusionProof_input {
+        uint64 seq;
+    };
+    struct GetInclusionProof_output {
+        id     siblings[QM_MMR_MAX_HEIGHT];  // leaf upwards; left neighbour where bit h of seq - 1 is set
+        id     peaks[QM_MMR_MAX_HEIGHT];     // left to right, tallest first
+        id     root;
+        uint64 leafCount;     // size of the MMR the proof is against
+        uint32 siblingCount;  // also the height of the peak the path ends at
+        uint32 peakCount;
+        uint32 peakIndex;     // peaks[] entry the path ends at
+        uint8  available;     // 0 if seq is not posted yet or a sibling was overwritten
+    };
+
+    // Verify by hashing the QM_MmrLeaf of the entry up through siblings[],
+    // checking the result equals peaks[peakIndex], then bagging peaks[] into root
+    PUBLIC_FUNCTION(GetInclusionProof)
+        output.available = 0;
+        output.root      = _mmrRoot(qpi);
+        output.leafCount = msgSeq;
+        output.siblingCount = 0;
+        output.peakCount    = 0;
+        output.peakIndex    = 0;
+
+        uint64 leaf  = input.seq - 1;
+        uint64 start = 0;  // first leaf under the current peak
+        uint8  found = input.seq != 0 && input.seq <= msgSeq;
+        for (uint32 i = 0; i < QM_MMR_MAX_HEIGHT; i++) {
+            uint32 h = QM_MMR_MAX_HEIGHT - 1 - i;
+            if (!((msgSeq >> h) & 1)) continue;
+            output.peaks[output.peakCount] = mmrPeaks[h];
+            if (found && leaf >= start && leaf - start < (1ULL << h)) {
+                output.siblingCount = h;
+                output.peakIndex    = output.peakCount;
+            }
+            output.peakCount++;
+            start += 1ULL << h;
+        }
+        if (!found) return;
+
+        for (uint32 h = 0; h < output.siblingCount; h++) {
+            uint64 sibling = (leaf >> h) ^ 1;
+            if (!_mmrHasNode(h, sibling)) return;
+            output.siblings[h] = mmrNodes[_mmrNodeSlot(h, sibling)];
+        }
+        output.available = 1;
+    _
+
+    // ── Function: GetSegmentRoot ──────────────────────────────────────────────
+
+    struct GetSegmentRoot_input {
+        uint64 segment;  // (seq - 1) / QM_SEGMENT_SIZE
+    };
+    struct GetSegmentRoot_output {
+        id     root;          // Merkle root of the segment's QM_SEGMENT_SIZE leaves
+        uint64 firstSeq;
+        uint64 closedCount;   // segments closed so far
+        uint32 firstTick;
+        uint32 lastTick;
+        uint16 epoch;
+        uint8  found;         // 0 if the segment is still open or has left the table
+    };
+
+    // Lets an archive prove an evicted entry: rebuild the segment's subtree from
+    // archived metadata and compare its root with this one
+    PUBLIC_FUNCTION(GetSegmentRoot)
+        output.found       = 0;
+        output.closedCount = msgSeq / QM_SEGMENT_SIZE;
+
+        QM_Segment& seg = segments[input.segment % QM_SEGMENT_TABLE_SIZE];
+        if (input.segment >= output.closedCount ||
+            seg.firstSeq != input.segment * QM_SEGMENT_SIZE + 1) return;
+        output.root      = seg.root;
+        output.firstSeq  = seg.firstSeq;
+        output.firstTick = seg.firstTick;
+        output.lastTick  = seg.lastTick;
+        output.epoch     = seg.epoch;
+        output.found     = 1;
+    _
+
     // ── Registration ─────────────────────────────────────────────────────────
 
     REGISTER_USER_FUNCTIONS_AND_PROCEDURES
         REGISTER_FUNCTION(LookupUser)
         REGISTER_FUNCTION(LookupUserByOwner)
         REGISTER_FUNCTION(GetMessageMeta)
+        REGISTER_FUNCTION(GetMessageMetaBySeq)
+        REGISTER_FUNCTION(GetMessageMetaRange)
+        REGISTER_FUNCTION(GetInbox)
+        REGISTER_FUNCTION(GetInboxHead)
+        REGISTER_FUNCTION(GetOutbox)
+        REGISTER_FUNCTION(GetMessagesByTickRange)
+        REGISTER_FUNCTION(VerifyDelivery)
+        REGISTER_FUNCTION(GetLogRoot)
+        REGISTER_FUNCTION(GetInclusionProof)
+        REGISTER_FUNCTION(GetSegmentRoot)
+        REGISTER_FUNCTION(GetMulticastReceivers)
+        REGISTER_FUNCTION(VerifyBatchLeaf)
         REGISTER_PROCEDURE(RegisterUser)
         REGISTER_PROCEDURE(UpdatePubkey)
         REGISTER_PROCEDURE(DeactivateUser)
         REGISTER_PROCEDURE(PostMessageMeta)
+        REGISTER_PROCEDURE(PostMessageMetaBatch)
+        REGISTER_PROCEDURE(PostMulticastMeta)
+        REGISTER_PROCEDURE(PostBatchRoot)
+        REGISTER_PROCEDURE(AddDeviceLane)
     _
 };
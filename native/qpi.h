@@ -0,0 +1,266 @@
+#pragma once
+
+/**
+ * Native QPI shim
+ *
+ * Just enough of the Qubic contract API to compile QubicMessenger.h as a
+ * plain host library, so the contract can be unit-tested, profiled and
+ * benchmarked outside the Qubic core tree.
+ *
+ * As on chain, a contract only sees its execution context (tick, epoch,
+ * invocator, balances) through the qpi argument of each procedure and
+ * function body; there is no global context, so a helper that reaches for
+ * qpi without taking it as a parameter fails to compile here too. Hosts own
+ * a QpiContext, set it up with setTick() and friends, and pass it in.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <unordered_map>
+
+namespace QPI {
+
+// ─── Scalar Types ─────────────────────────────────────────────────────────────
+
+typedef int8_t   sint8;
+typedef uint8_t  uint8;
+typedef int16_t  sint16;
+typedef uint16_t uint16;
+typedef int32_t  sint32;
+typedef uint32_t uint32;
+typedef int64_t  sint64;
+typedef uint64_t uint64;
+
+// ─── id (m256i) ───────────────────────────────────────────────────────────────
+
+union alignas(32) id {
+    uint8 m256i_u8[32];
+    struct { uint64 _0, _1, _2, _3; } u64;
+
+    static id zero() { id v; std::memset(&v, 0, sizeof(v)); return v; }
+
+    bool operator==(const id& o) const { return std::memcmp(m256i_u8, o.m256i_u8, 32) == 0; }
+    bool operator!=(const id& o) const { return !(*this == o); }
+};
+
+static_assert(sizeof(id) == 32, "id must be 32 bytes");
+
+#define NULL_ID QPI::id::zero()
+
+struct Entity {
+    id     publicKey;
+    sint64 incomingAmount;
+    sint64 outgoingAmount;
+    uint32 numberOfIncomingTransfers;
+    uint32 numberOfOutgoingTransfers;
+    uint32 latestIncomingTransferTick;
+    uint32 latestOutgoingTransferTick;
+};
+
+// ─── Memory Helpers ───────────────────────────────────────────────────────────
+
+// Re-exported rather than wrapped: contracts pull QPI in with a using-directive,
+// and a second overload would make unqualified calls in host code ambiguous.
+using ::memcpy;
+using ::memcmp;
+
+// ─── KangarooTwelve ───────────────────────────────────────────────────────────
+
+namespace k12 {
+
+inline uint64 rotl(uint64 v, unsigned n) { return (v << n) | (v >> (64 - n)); }
+
+// Keccak-p[1600, 12]: the last 12 rounds of Keccak-f[1600]
+inline void permute(uint64 st[25]) {
+    static const uint64 rc[12] = {
+        0x000000008000808BULL, 0x800000000000008BULL, 0x8000000000008089ULL,
+        0x8000000000008003ULL, 0x8000000000008002ULL, 0x8000000000000080ULL,
+        0x000000000000800AULL, 0x800000008000000AULL, 0x8000000080008081ULL,
+        0x8000000000008080ULL, 0x0000000080000001ULL, 0x8000000080008008ULL,
+    };
+    static const unsigned rotc[24] = {
+        1, 3, 6, 10, 15, 21, 28, 36, 45, 55, 2, 14,
+        27, 41, 56, 8, 25, 43, 62, 18, 39, 61, 20, 44,
+    };
+    static const unsigned piln[24] = {
+        10, 7, 11, 17, 18, 3, 5, 16, 8, 21, 24, 4,
+        15, 23, 19, 13, 12, 2, 20, 14, 22, 9, 6, 1,
+    };
+    for (int round = 0; round < 12; round++) {
+        uint64 bc[5];
+        for (int i = 0; i < 5; i++) bc[i] = st[i] ^ st[i + 5] ^ st[i + 10] ^ st[i + 15] ^ st[i + 20];
+        for (int i = 0; i < 5; i++) {
+            uint64 t = bc[(i + 4) % 5] ^ rotl(bc[(i + 1) % 5], 1);
+            for (int j = 0; j < 25; j += 5) st[j + i] ^= t;
+        }
+        uint64 t = st[1];
+        for (int i = 0; i < 24; i++) {
+            unsigned j = piln[i];
+            bc[0] = st[j];
+            st[j] = rotl(t, rotc[i]);
+            t = bc[0];
+        }
+        for (int j = 0; j < 25; j += 5) {
+            for (int i = 0; i < 5; i++) bc[i] = st[j + i];
+            for (int i = 0; i < 5; i++) st[j + i] ^= (~bc[(i + 1) % 5]) & bc[(i + 2) % 5];
+        }
+        st[0] ^= rc[round];
+    }
+}
+
+// Incremental TurboSHAKE128 sponge (rate 168 bytes, little-endian lanes)
+struct Sponge {
+    uint64 st[25] = {};
+    unsigned pos = 0;
+
+    void xorByte(unsigned i, uint8 b) { st[i / 8] ^= (uint64)b << (8 * (i % 8)); }
+
+    void absorb(const uint8* p, size_t n) {
+        while (n--) {
+            xorByte(pos++, *p++);
+            if (pos == 168) { permute(st); pos = 0; }
+        }
+    }
+
+    void finish(uint8 domain, uint8* out, size_t outLen) {
+        xorByte(pos, domain);
+        xorByte(167, 0x80);
+        permute(st);
+        for (size_t i = 0; i < outLen; i++) {
+            if (i && i % 168 == 0) permute(st);
+            out[i] = (uint8)(st[(i % 168) / 8] >> (8 * (i % 8)));
+        }
+    }
+};
+
+// K12(M, C = "") with a 32-byte output, including tree mode for long inputs
+inline void hash(const void* data, size_t len, uint8 out[32]) {
+    static const size_t chunk = 8192;
+    const uint8* m = (const uint8*)data;
+    const uint8 emptyCustom = 0x00; // right_encode(0)
+    size_t total = len + 1;
+
+    if (total <= chunk) {
+        Sponge s;
+        s.absorb(m, len);
+        s.absorb(&emptyCustom, 1);
+        s.finish(0x07, out, 32);
+        return;
+    }
+
+    // S = M || right_encode(0); the final node absorbs S_0, then one chaining
+    // value per remaining chunk.
+    auto byteAt = [&](size_t i) -> uint8 { return i < len ? m[i] : emptyCustom; };
+    Sponge final;
+    for (size_t i = 0; i < chunk; i++) { uint8 b = byteAt(i); final.absorb(&b, 1); }
+    static const uint8 marker[8] = { 0x03, 0, 0, 0, 0, 0, 0, 0 };
+    final.absorb(marker, 8);
+
+    uint64 leaves = 0;
+    for (size_t off = chunk; off < total; off += chunk) {
+        Sponge leaf;
+        size_t end = off + chunk < total ? off + chunk : total;
+        if (end <= len) {
+            leaf.absorb(m + off, end - off);
+        } else {
+            for (size_t i = off; i < end; i++) { uint8 b = byteAt(i); leaf.absorb(&b, 1); }
+        }
+        uint8 cv[32];
+        leaf.finish(0x0B, cv, 32);
+        final.absorb(cv, 32);
+        leaves++;
+    }
+
+    // right_encode(leaves)
+    uint8 enc[9];
+    unsigned n = 0;
+    for (uint64 v = leaves; v; v >>= 8) n++;
+    for (unsigned i = 0; i < n; i++) enc[i] = (uint8)(leaves >> (8 * (n - 1 - i)));
+    enc[n] = (uint8)n;
+    final.absorb(enc, n + 1);
+    static const uint8 terminator[2] = { 0xFF, 0xFF };
+    final.absorb(terminator, 2);
+    final.finish(0x06, out, 32);
+}
+
+} // namespace k12
+
+// ─── Execution Context ────────────────────────────────────────────────────────
+
+struct IdHasher {
+    size_t operator()(const id& v) const { return (size_t)v.u64._0; }
+};
+
+// What a contract sees of the call it is running in. Functions get the read
+// side; procedures get QpiContextProcedureCall, which also passes wherever a
+// function context is expected, so helpers shared by both take the base.
+class QpiContextFunctionCall {
+public:
+    uint32 tick() const     { return _tick; }
+    uint16 epoch() const    { return _epoch; }
+    id     invocator() const { return _invocator; }
+
+    bool getEntity(const id& who, Entity& entity) const {
+        std::memset(&entity, 0, sizeof(entity));
+        entity.publicKey = who;
+        auto it = _balances.find(who);
+        if (it == _balances.end()) return false;
+        entity.incomingAmount = it->second;
+        return true;
+    }
+
+    template <typename T>
+    id K12(const T& data) const {
+        id out;
+        k12::hash(&data, sizeof(T), out.m256i_u8);
+        return out;
+    }
+
+protected:
+    uint32 _tick = 0;
+    uint16 _epoch = 0;
+    id     _invocator = id::zero();
+    std::unordered_map<id, sint64, IdHasher> _balances;
+};
+
+class QpiContextProcedureCall : public QpiContextFunctionCall {};
+
+// Host side of the context: tests, tools and the dispatcher set it up before
+// each call
+class QpiContext : public QpiContextProcedureCall {
+public:
+
+    void setTick(uint32 tick)              { _tick = tick; }
+    void setEpoch(uint16 epoch)            { _epoch = epoch; }
+    void setInvocator(const id& invocator) { _invocator = invocator; }
+    void setBalance(const id& who, sint64 amount) { _balances[who] = amount; }
+    void reset() { _tick = 0; _epoch = 0; _invocator = id::zero(); _balances.clear(); }
+};
+
+} // namespace QPI
+
+// ─── Contract Definition Macros ───────────────────────────────────────────────
+//
+// Procedures and functions become ordinary member functions that take the
+// call context first, as qpi; REGISTER_* hands each one to a caller-supplied
+// registry so hosts can dispatch by index.
+
+#define PUBLIC_FUNCTION(name) \
+    void name(const QPI::QpiContextFunctionCall& qpi, const name##_input& input, name##_output& output) {
+
+#define PUBLIC_PROCEDURE(name) \
+    void name(const QPI::QpiContextProcedureCall& qpi, const name##_input& input, name##_output& output) {
+
+#define _ }
+
+#define REGISTER_USER_FUNCTIONS_AND_PROCEDURES \
+    template <typename Registry> \
+    void registerUserFunctionsAndProcedures(Registry& registry) {
+
+#define REGISTER_FUNCTION(name) \
+    registry.function(#name, this, &std::remove_reference_t<decltype(*this)>::name);
+
+#define REGISTER_PROCEDURE(name) \
+    registry.procedure(#name, this, &std::remove_reference_t<decltype(*this)>::name);
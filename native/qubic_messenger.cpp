@@ -0,0 +1,45 @@
+#include "qubic_messenger.h"
+
+#include <cstring>
+
+namespace qm {
+
+std::unique_ptr<QubicMessenger> createContract() {
+    std::unique_ptr<QubicMessenger> contract(new QubicMessenger);
+    std::memset(contract.get(), 0, sizeof(QubicMessenger));
+    return contract;
+}
+
+Dispatcher::Dispatcher(QubicMessenger& contract, QPI::QpiContext& context) : _context(context) {
+    contract.registerUserFunctionsAndProcedures(*this);
+}
+
+const Entry* Dispatcher::procedure(QPI::uint32 index) const {
+    if (index == 0 || index > _procedures.size()) return nullptr;
+    return &_procedures[index - 1];
+}
+
+const Entry* Dispatcher::function(QPI::uint32 index) const {
+    if (index >= _functions.size()) return nullptr;
+    return &_functions[index];
+}
+
+bool Dispatcher::invoke(const Entry* entry, const QPI::uint8* input, size_t inputLen,
+                        std::vector<QPI::uint8>& output) {
+    if (!entry) return false;
+    output.resize(entry->outputSize);
+    entry->invoke(input, inputLen, output.data());
+    return true;
+}
+
+bool Dispatcher::invokeProcedure(QPI::uint32 index, const QPI::uint8* input, size_t inputLen,
+                                 std::vector<QPI::uint8>& output) const {
+    return invoke(procedure(index), input, inputLen, output);
+}
+
+bool Dispatcher::invokeFunction(QPI::uint32 index, const QPI::uint8* input, size_t inputLen,
+                                std::vector<QPI::uint8>& output) const {
+    return invoke(function(index), input, inputLen, output);
+}
+
+} // namespace qm
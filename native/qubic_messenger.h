@@ -0,0 +1,101 @@
+#pragma once
+
+/**
+ * QubicMessenger — native host build
+ *
+ * Compiles the contract against the QPI shim in qpi.h and adds what a host
+ * needs to drive it: zeroed state allocation and dispatch by the same
+ * procedure/function indexes qubic-client.ts uses.
+ */
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "qpi.h"
+#include "../QubicMessenger.h"
+
+// The contract's body terminator; host code is free to use the name
+#undef _
+
+namespace qm {
+
+// Contract state starts zeroed on chain. It is ~16 MB, so it lives on the heap.
+std::unique_ptr<QubicMessenger> createContract();
+
+// One registered procedure or function
+struct Entry {
+    std::string name;
+    size_t      inputSize;
+    size_t      outputSize;
+    // Runs the entry on raw input bytes: shorter input is zero-padded, longer
+    // input is truncated, and the output is zeroed before the call
+    std::function<void(const QPI::uint8* input, size_t inputLen, QPI::uint8* output)> invoke;
+};
+
+// Entries in REGISTER_USER_FUNCTIONS_AND_PROCEDURES order. Functions are
+// numbered from 0 and procedures from 1, matching FUNC and PROC in
+// qubic-client.ts.
+// Every call runs with the context passed to the constructor; set it up
+// through context() before invoking.
+class Dispatcher {
+public:
+    Dispatcher(QubicMessenger& contract, QPI::QpiContext& context);
+
+    QPI::QpiContext& context() const { return _context; }
+
+    const Entry* procedure(QPI::uint32 index) const;
+    const Entry* function(QPI::uint32 index) const;
+
+    const std::vector<Entry>& procedures() const { return _procedures; }
+    const std::vector<Entry>& functions() const  { return _functions; }
+
+    // Returns false for an unknown index; output is resized to the entry's output size
+    bool invokeProcedure(QPI::uint32 index, const QPI::uint8* input, size_t inputLen,
+                         std::vector<QPI::uint8>& output) const;
+    bool invokeFunction(QPI::uint32 index, const QPI::uint8* input, size_t inputLen,
+                        std::vector<QPI::uint8>& output) const;
+
+    // Called back by registerUserFunctionsAndProcedures
+    template <typename Contract, typename Context, typename In, typename Out>
+    void procedure(const char* name, Contract* contract, void (Contract::*fn)(const Context&, const In&, Out&)) {
+        _procedures.push_back(makeEntry(name, contract, fn));
+    }
+    template <typename Contract, typename Context, typename In, typename Out>
+    void function(const char* name, Contract* contract, void (Contract::*fn)(const Context&, const In&, Out&)) {
+        _functions.push_back(makeEntry(name, contract, fn));
+    }
+
+private:
+    template <typename Contract, typename Context, typename In, typename Out>
+    Entry makeEntry(const char* name, Contract* contract, void (Contract::*fn)(const Context&, const In&, Out&)) {
+        // Scratch structs are reused across calls; new honours id's 32-byte alignment
+        std::shared_ptr<In>  in(new In());
+        std::shared_ptr<Out> out(new Out());
+        Entry entry;
+        entry.name       = name;
+        entry.inputSize  = sizeof(In);
+        entry.outputSize = sizeof(Out);
+        QPI::QpiContext* context = &_context;
+        entry.invoke = [contract, context, fn, in, out](const QPI::uint8* input, size_t inputLen, QPI::uint8* output) {
+            size_t n = inputLen < sizeof(In) ? inputLen : sizeof(In);
+            std::memset(in.get(), 0, sizeof(In));
+            if (n) std::memcpy(in.get(), input, n);
+            std::memset(out.get(), 0, sizeof(Out));
+            (contract->*fn)(*context, *in, *out);
+            std::memcpy(output, out.get(), sizeof(Out));
+        };
+        return entry;
+    }
+
+    static bool invoke(const Entry* entry, const QPI::uint8* input, size_t inputLen,
+                       std::vector<QPI::uint8>& output);
+
+    QPI::QpiContext&   _context;
+    std::vector<Entry> _procedures;
+    std::vector<Entry> _functions;
+};
+
+} // namespace qm
@@ -0,0 +1,436 @@
+/**
+ * Benchmarks for the QubicMessenger contract, run natively against the QPI shim.
+ *
+ * Every registry procedure and log accessor is timed at 0%, 50% and 100% of
+ * QM_MAX_USERS, with the message log half full (before the ring wraps) and
+ * past its first wraparound. Each benchmark starts from its own copy of the
+ * scenario state and runs its operations back to back on it, so later calls
+ * see the effects of earlier ones (a registered slot, a used nonce). Filling
+ * the log takes two users, so the 0% scenarios hold two registered users.
+ *
+ * With the registry full, linear owner and nickname scans are also timed
+ * over the contract's registry columns and over a copy laid out as the
+ * row-per-user QM_UserRecord array the columns replaced.
+ *
+ * Usage: qubic_messenger_bench [opsPerBenchmark]   (1 to 1000000, default 4096)
+ *
+ * instr/op comes from the hardware instruction counter (perf_event_open) and
+ * reads n/a where the kernel does not allow it.
+ */
+
+#include "qubic_messenger.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <vector>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+using namespace QPI;
+
+// ─── Instruction Counter ──────────────────────────────────────────────────────
+
+class InstructionCounter {
+public:
+    InstructionCounter() {
+#if defined(__linux__)
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.type           = PERF_TYPE_HARDWARE;
+        attr.size           = sizeof(attr);
+        attr.config         = PERF_COUNT_HW_INSTRUCTIONS;
+        attr.disabled       = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv     = 1;
+        _fd = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+#endif
+    }
+    ~InstructionCounter() {
+#if defined(__linux__)
+        if (_fd >= 0) close(_fd);
+#endif
+    }
+
+    bool available() const { return _fd >= 0; }
+
+    void start() {
+#if defined(__linux__)
+        if (_fd < 0) return;
+        ioctl(_fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(_fd, PERF_EVENT_IOC_ENABLE, 0);
+#endif
+    }
+
+    uint64 stop() {
+        uint64 count = 0;
+#if defined(__linux__)
+        if (_fd < 0) return 0;
+        ioctl(_fd, PERF_EVENT_IOC_DISABLE, 0);
+        if (read(_fd, &count, sizeof(count)) != (ssize_t)sizeof(count)) count = 0;
+#endif
+        return count;
+    }
+
+private:
+    int _fd = -1;
+};
+
+// ─── Scenario ─────────────────────────────────────────────────────────────────
+
+// Call context every benchmark drives the contract with
+static QpiContext qpi;
+
+static id userId(uint64 n) {
+    id v = id::zero();
+    v.u64._0 = n * 0x9E3779B97F4A7C15ULL;
+    v.u64._1 = n;
+    return v;
+}
+
+static void nicknameOf(uint64 n, uint8 out[QM_NICKNAME_LEN]) {
+    std::memset(out, 0, QM_NICKNAME_LEN);
+    std::snprintf((char*)out, QM_NICKNAME_LEN, "user%llu", (unsigned long long)n);
+}
+
+// Contract state plus the host-side bookkeeping needed to keep posting
+struct Scenario {
+    std::unique_ptr<QubicMessenger> contract;
+    uint32              users = 0;    // registered as userId(1..users)
+    uint32              tick  = 0;
+    std::vector<uint32> nonces;       // next nonce per user, index 1..users
+    bool                wrapped = false;
+};
+
+static void registerUsers(Scenario& s, uint32 count) {
+    QubicMessenger::RegisterUser_input  in;
+    QubicMessenger::RegisterUser_output out;
+    std::memset(&in, 0, sizeof(in));
+    for (uint32 u = s.users + 1; u <= s.users + count; u++) {
+        qpi.setInvocator(userId(u));
+        nicknameOf(u, in.nickname);
+        in.pubkey[0] = (uint8)u;
+        s.contract->RegisterUser(qpi, in, out);
+        if (out.slotIndex < 0) {
+            std::fprintf(stderr, "setup: RegisterUser failed for user %u (%d)\n", u, out.slotIndex);
+            std::exit(1);
+        }
+    }
+    s.users += count;
+    s.nonces.resize(s.users + 1, 1);
+}
+
+// Posts count messages between random pairs of registered users
+static void fillLog(Scenario& s, uint32 count) {
+    QubicMessenger::PostMessageMeta_input  in;
+    QubicMessenger::PostMessageMeta_output out;
+    std::memset(&in, 0, sizeof(in));
+    std::mt19937_64 rng(7);
+    for (uint32 i = 0; i < count; i++) {
+        uint32 from = 1 + i % s.users;
+        uint32 to   = 1 + (uint32)(rng() % (s.users - 1));
+        if (to >= from) to++;
+        s.tick += QM_RATE_REFILL_TICKS_FREE;
+        qpi.setTick(s.tick);
+        qpi.setInvocator(userId(from));
+        in.receiver = userId(to);
+        std::memcpy(in.contentHash, &i, sizeof(i));
+        in.nonce = s.nonces[from]++;
+        s.contract->PostMessageMeta(qpi, in, out);
+        if (!out.success) {
+            std::fprintf(stderr, "setup: PostMessageMeta failed (%u)\n", out.errorCode);
+            std::exit(1);
+        }
+    }
+}
+
+static Scenario buildScenario(uint32 users, bool wrapped) {
+    Scenario s;
+    s.contract = qm::createContract();
+    qpi.reset();
+    s.tick = 1000;
+    qpi.setTick(s.tick);
+    registerUsers(s, users < 2 ? 2 : users);
+    fillLog(s, wrapped ? QM_MSG_LOG_SIZE + QM_MSG_LOG_SIZE / 8 : QM_MSG_LOG_SIZE / 2);
+    s.wrapped = wrapped;
+    return s;
+}
+
+static Scenario copyScenario(const Scenario& base) {
+    Scenario s;
+    s.contract = qm::createContract();
+    std::memcpy(s.contract.get(), base.contract.get(), sizeof(QubicMessenger));
+    s.users   = base.users;
+    s.tick    = base.tick;
+    s.nonces  = base.nonces;
+    s.wrapped = base.wrapped;
+    qpi.setTick(s.tick);
+    return s;
+}
+
+// ─── Measurement ──────────────────────────────────────────────────────────────
+
+struct Result {
+    double ns;
+    double instructions;   // < 0 when unavailable
+    double accepted;       // fraction of calls that succeeded
+};
+
+static InstructionCounter* counter;
+
+// Times body(i) for i in [0, ops); body returns 1 if the call succeeded
+template <typename Body>
+static Result measure(uint32 ops, Body body) {
+    uint32 ok = 0;
+    counter->start();
+    auto begin = std::chrono::steady_clock::now();
+    for (uint32 i = 0; i < ops; i++) ok += body(i);
+    auto end = std::chrono::steady_clock::now();
+    uint64 instructions = counter->stop();
+
+    Result r;
+    r.ns           = std::chrono::duration<double, std::nano>(end - begin).count() / ops;
+    r.instructions = counter->available() ? (double)instructions / ops : -1.0;
+    r.accepted     = (double)ok / ops;
+    return r;
+}
+
+static void report(const char* name, const Scenario& s, uint32 ops, const Result& r) {
+    char instr[32];
+    if (r.instructions < 0) std::snprintf(instr, sizeof(instr), "n/a");
+    else                    std::snprintf(instr, sizeof(instr), "%.0f", r.instructions);
+    std::printf("%-20s %6u %4.0f%%  %-7s %6u %12.1f %12s %8.0f%%\n",
+                name, s.users, 100.0 * s.users / QM_MAX_USERS, s.wrapped ? "wrapped" : "half",
+                ops, r.ns, instr, 100.0 * r.accepted);
+}
+
+static uint64 pickUser(const Scenario& s, std::mt19937_64& rng) {
+    return 1 + rng() % s.users;
+}
+
+// ─── Benchmarks ───────────────────────────────────────────────────────────────
+
+static void benchLookupUser(const Scenario& base, uint32 ops) {
+    Scenario s = copyScenario(base);
+    std::mt19937_64 rng(1);
+    std::vector<QubicMessenger::LookupUser_input> inputs(ops);
+    for (auto& in : inputs) nicknameOf(pickUser(s, rng), in.nickname);
+    QubicMessenger::LookupUser_output out;
+    report("LookupUser", s, ops, measure(ops, [&](uint32 i) {
+        s.contract->LookupUser(qpi, inputs[i], out);
+        return out.found;
+    }));
+}
+
+static void benchLookupUserByOwner(const Scenario& base, uint32 ops) {
+    Scenario s = copyScenario(base);
+    std::mt19937_64 rng(2);
+    std::vector<QubicMessenger::LookupUserByOwner_input> inputs(ops);
+    for (auto& in : inputs) in.owner = userId(pickUser(s, rng));
+    QubicMessenger::LookupUserByOwner_output out;
+    report("LookupUserByOwner", s, ops, measure(ops, [&](uint32 i) {
+        s.contract->LookupUserByOwner(qpi, inputs[i], out);
+        return out.found;
+    }));
+}
+
+static void benchUpdatePubkey(const Scenario& base, uint32 ops) {
+    Scenario s = copyScenario(base);
+    std::mt19937_64 rng(3);
+    std::vector<id> callers(ops);
+    for (auto& caller : callers) caller = userId(pickUser(s, rng));
+    QubicMessenger::UpdatePubkey_input  in;
+    QubicMessenger::UpdatePubkey_output out;
+    std::memset(&in, 0xAB, sizeof(in));
+    report("UpdatePubkey", s, ops, measure(ops, [&](uint32 i) {
+        qpi.setInvocator(callers[i]);
+        s.contract->UpdatePubkey(qpi, in, out);
+        return out.success;
+    }));
+}
+
+// Registers fresh owners on top of the scenario; at 100% these are rejected
+// unless deactivated slots are free for reuse
+static void benchRegisterUser(const Scenario& base, uint32 ops) {
+    Scenario s = copyScenario(base);
+    std::vector<QubicMessenger::RegisterUser_input> inputs(ops);
+    for (uint32 i = 0; i < ops; i++) {
+        std::memset(&inputs[i], 0, sizeof(inputs[i]));
+        std::snprintf((char*)inputs[i].nickname, QM_NICKNAME_LEN, "new%u", i);
+    }
+    QubicMessenger::RegisterUser_output out;
+    report("RegisterUser", s, ops, measure(ops, [&](uint32 i) {
+        qpi.setInvocator(userId(2 * QM_MAX_USERS + i));
+        s.contract->RegisterUser(qpi, inputs[i], out);
+        return out.slotIndex >= 0;
+    }));
+}
+
+// Deactivates distinct users in random order; callers beyond the registry miss
+static void benchDeactivateUser(const Scenario& base, uint32 ops) {
+    Scenario s = copyScenario(base);
+    std::vector<uint64> callers;
+    for (uint64 u = 1; u <= s.users; u++) callers.push_back(u);
+    std::shuffle(callers.begin(), callers.end(), std::mt19937_64(4));
+    while (callers.size() < ops) callers.push_back(QM_MAX_USERS + 1 + callers.size());
+    QubicMessenger::DeactivateUser_input  in;
+    QubicMessenger::DeactivateUser_output out;
+    report("DeactivateUser", s, ops, measure(ops, [&](uint32 i) {
+        qpi.setInvocator(userId(callers[i]));
+        s.contract->DeactivateUser(qpi, in, out);
+        return out.success;
+    }));
+}
+
+static void benchPostMessageMeta(const Scenario& base, uint32 ops) {
+    Scenario s = copyScenario(base);
+    std::mt19937_64 rng(5);
+    std::vector<uint32> senders(ops);
+    std::vector<QubicMessenger::PostMessageMeta_input> inputs(ops);
+    for (uint32 i = 0; i < ops; i++) {
+        uint32 from = 1 + (uint32)(rng() % s.users);
+        uint32 to   = 1 + (uint32)(rng() % (s.users - 1));
+        if (to >= from) to++;
+        std::memset(&inputs[i], 0, sizeof(inputs[i]));
+        inputs[i].receiver = userId(to);
+        std::memcpy(inputs[i].contentHash, &i, sizeof(i));
+        inputs[i].contentHash[31] = 0xB5;
+        inputs[i].nonce = s.nonces[from]++;
+        senders[i] = from;
+    }
+    QubicMessenger::PostMessageMeta_output out;
+    report("PostMessageMeta", s, ops, measure(ops, [&](uint32 i) {
+        s.tick += QM_RATE_REFILL_TICKS_FREE;  // keeps every sender's bucket topped up
+        qpi.setTick(s.tick);
+        qpi.setInvocator(userId(senders[i]));
+        s.contract->PostMessageMeta(qpi, inputs[i], out);
+        return out.success;
+    }));
+}
+
+static void benchGetMessageMeta(const Scenario& base, uint32 ops) {
+    Scenario s = copyScenario(base);
+    std::mt19937_64 rng(6);
+    std::vector<QubicMessenger::GetMessageMeta_input> inputs(ops);
+    for (auto& in : inputs) in.logIndex = (uint32)(rng() % QM_MSG_LOG_SIZE);
+    QubicMessenger::GetMessageMeta_output out;
+    report("GetMessageMeta", s, ops, measure(ops, [&](uint32 i) {
+        s.contract->GetMessageMeta(qpi, inputs[i], out);
+        return out.valid;
+    }));
+}
+
+// Row-per-user registry record, as stored before the registry was split into
+// columns; kept here only to compare the two layouts
+struct UserRecordRow {
+    uint8  nickname[QM_NICKNAME_LEN];
+    uint8  pubkey[QM_PUBKEY_LEN];
+    id     owner;
+    uint32 registeredTick;
+    uint32 lastUpdateTick;
+    uint8  active;
+};
+
+// Times a linear scan for a random active user's owner and nickname, once
+// over the registry columns and once over the same users in rows
+static void benchRegistryLayout(const Scenario& s, uint32 ops) {
+    const QubicMessenger& c = *s.contract;
+    std::vector<UserRecordRow> rows(c.userCount);
+    for (uint32 slot = 0; slot < c.userCount; slot++) {
+        UserRecordRow& row = rows[slot];
+        std::memcpy(row.nickname, c.userNickname[slot], QM_NICKNAME_LEN);
+        std::memcpy(row.pubkey,   c.userPubkey[slot],   QM_PUBKEY_LEN);
+        row.owner          = c.userOwner[slot];
+        row.registeredTick = c.userRegisteredTick[slot];
+        row.lastUpdateTick = c.userLastUpdateTick[slot];
+        row.active         = (uint8)((c.userActive[slot / 64] >> (slot % 64)) & 1);
+    }
+    auto columnActive = [&](uint32 slot) { return (c.userActive[slot / 64] >> (slot % 64)) & 1; };
+
+    std::mt19937_64 rng(8);
+    std::vector<id> owners(ops);
+    std::vector<std::vector<uint8>> nicknames(ops, std::vector<uint8>(QM_NICKNAME_LEN));
+    for (uint32 i = 0; i < ops; i++) {
+        uint64 u = pickUser(s, rng);
+        owners[i] = userId(u);
+        nicknameOf(u, nicknames[i].data());
+    }
+
+    report("ScanOwner rows", s, ops, measure(ops, [&](uint32 i) {
+        for (const UserRecordRow& row : rows) {
+            if (row.active && row.owner == owners[i]) return 1;
+        }
+        return 0;
+    }));
+    report("ScanOwner columns", s, ops, measure(ops, [&](uint32 i) {
+        for (uint32 slot = 0; slot < c.userCount; slot++) {
+            if (columnActive(slot) && c.userOwner[slot] == owners[i]) return 1;
+        }
+        return 0;
+    }));
+    report("ScanNickname rows", s, ops, measure(ops, [&](uint32 i) {
+        for (const UserRecordRow& row : rows) {
+            if (row.active && std::memcmp(row.nickname, nicknames[i].data(), QM_NICKNAME_LEN) == 0) return 1;
+        }
+        return 0;
+    }));
+    report("ScanNickname columns", s, ops, measure(ops, [&](uint32 i) {
+        for (uint32 slot = 0; slot < c.userCount; slot++) {
+            if (columnActive(slot) && std::memcmp(c.userNickname[slot], nicknames[i].data(), QM_NICKNAME_LEN) == 0) return 1;
+        }
+        return 0;
+    }));
+}
+
+static const uint32 MAX_OPS = 1000000;
+
+// Parses a decimal operation count in [1, MAX_OPS]; returns 0 if text is not one
+static uint32 parseOps(const char* text) {
+    uint64 ops = 0;
+    if (!*text) return 0;
+    for (const char* p = text; *p; p++) {
+        if (*p < '0' || *p > '9') return 0;
+        ops = ops * 10 + (uint64)(*p - '0');
+        if (ops > MAX_OPS) return 0;
+    }
+    return (uint32)ops;
+}
+
+int main(int argc, char** argv) {
+    uint32 ops = 4096;
+    if (argc > 2 || (argc == 2 && (ops = parseOps(argv[1])) == 0)) {
+        std::fprintf(stderr, "usage: %s [opsPerBenchmark]   (1 to %u, default 4096)\n", argv[0], MAX_OPS);
+        return 2;
+    }
+
+    InstructionCounter instructions;
+    counter = &instructions;
+
+    std::printf("%-20s %6s %5s  %-7s %6s %12s %12s %9s\n",
+                "benchmark", "users", "fill", "log", "ops", "ns/op", "instr/op", "accepted");
+
+    const uint32 fills[] = { 0, QM_MAX_USERS / 2, QM_MAX_USERS };
+    for (bool wrapped : { false, true }) {
+        for (uint32 users : fills) {
+            Scenario base = buildScenario(users, wrapped);
+            benchLookupUser(base, ops);
+            benchLookupUserByOwner(base, ops);
+            benchUpdatePubkey(base, ops);
+            benchRegisterUser(base, ops);
+            benchDeactivateUser(base, ops);
+            benchPostMessageMeta(base, ops);
+            benchGetMessageMeta(base, ops);
+            if (users == QM_MAX_USERS && !wrapped) benchRegistryLayout(base, ops);
+        }
+    }
+    return 0;
+}
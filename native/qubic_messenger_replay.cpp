@@ -0,0 +1,146 @@
+/**
+ * Replays a transaction trace against the natively built contract.
+ *
+ * Usage: qubic_messenger_replay TRACE
+ *
+ * The whole trace is loaded before the clock starts, then each record runs
+ * in order on a zeroed contract. Reports throughput, a log2 latency histogram
+ * per procedure and a running digest of every procedure output; two layouts
+ * or indexes that process the same trace correctly must print the same
+ * output digest. The raw state digest is also printed, but it depends on the
+ * state layout and only compares builds that share it.
+ */
+
+#include "qubic_messenger_trace.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+using namespace QPI;
+
+// Bucket b holds latencies in [2^b, 2^(b+1)) ns
+static const int HISTOGRAM_BUCKETS = 40;
+
+struct ProcedureStats {
+    uint64 calls = 0;
+    double totalNs = 0;
+    uint64 maxNs = 0;
+    uint64 buckets[HISTOGRAM_BUCKETS] = {};
+};
+
+static int bucketOf(uint64 ns) {
+    int b = 0;
+    while (b < HISTOGRAM_BUCKETS - 1 && (ns >> (b + 1))) b++;
+    return b;
+}
+
+// Upper bound of the bucket holding the q-quantile, never above the
+// largest latency actually seen
+static uint64 quantile(const ProcedureStats& s, double q) {
+    uint64 rank = (uint64)(q * (double)(s.calls - 1)) + 1, seen = 0;
+    for (int b = 0; b < HISTOGRAM_BUCKETS; b++) {
+        seen += s.buckets[b];
+        if (seen >= rank) return std::min<uint64>(2ULL << b, s.maxNs);
+    }
+    return s.maxNs;
+}
+
+static void printHex(const id& v) {
+    for (int i = 0; i < 32; i++) std::printf("%02x", v.m256i_u8[i]);
+}
+
+int main(int argc, char** argv) {
+    if (argc != 2) {
+        std::fprintf(stderr, "usage: %s TRACE\n", argv[0]);
+        return 2;
+    }
+
+    std::FILE* file = std::fopen(argv[1], "rb");
+    if (!file) {
+        std::fprintf(stderr, "cannot open %s\n", argv[1]);
+        return 1;
+    }
+    qm::TraceReader reader(file);
+    if (!reader.ok()) {
+        std::fprintf(stderr, "%s is not a version %u trace\n", argv[1], qm::TRACE_VERSION);
+        return 1;
+    }
+    std::vector<qm::TraceRecord> records;
+    qm::TraceRecord record;
+    while (reader.next(record)) records.push_back(record);
+    bool truncated = !reader.ok();
+    std::fclose(file);
+    if (truncated) {
+        std::fprintf(stderr, "warning: trace is truncated or corrupt after %zu records\n", records.size());
+    }
+
+    auto contract = qm::createContract();
+    QpiContext context;
+    qm::Dispatcher dispatch(*contract, context);
+
+    std::vector<ProcedureStats> stats(dispatch.procedures().size() + 1);
+    std::vector<uint8> output;
+    qm::OutputDigest outputs;
+    uint64 unknown = 0;
+    double contractNs = 0;
+
+    auto wallBegin = std::chrono::steady_clock::now();
+    for (const auto& r : records) {
+        auto begin = std::chrono::steady_clock::now();
+        bool known = qm::applyRecord(dispatch, r, output);
+        auto end = std::chrono::steady_clock::now();
+        if (!known) {
+            unknown++;
+            continue;
+        }
+        outputs.add(r.procedure, output);
+        uint64 ns = (uint64)std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count();
+        ProcedureStats& s = stats[r.procedure];
+        s.calls++;
+        s.totalNs += (double)ns;
+        if (ns > s.maxNs) s.maxNs = ns;
+        s.buckets[bucketOf(ns)]++;
+        contractNs += (double)ns;
+    }
+    double wallSec = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallBegin).count();
+
+    uint64 applied = records.size() - unknown;
+    std::printf("records:    %zu (%llu unknown procedure)\n", records.size(), (unsigned long long)unknown);
+    std::printf("wall:       %.3f s, %.0f tx/s\n", wallSec, wallSec > 0 ? applied / wallSec : 0.0);
+    std::printf("contract:   %.3f s, %.0f tx/s\n", contractNs / 1e9, contractNs > 0 ? applied / (contractNs / 1e9) : 0.0);
+
+    std::printf("\n%-3s %-22s %10s %10s %10s %10s %10s %10s\n",
+                "idx", "procedure", "calls", "mean ns", "p50 <=", "p90 <=", "p99 <=", "max ns");
+    for (uint32 p = 1; p < stats.size(); p++) {
+        const ProcedureStats& s = stats[p];
+        if (!s.calls) continue;
+        std::printf("%-3u %-22s %10llu %10.0f %10llu %10llu %10llu %10llu\n",
+                    p, dispatch.procedure(p)->name.c_str(), (unsigned long long)s.calls, s.totalNs / s.calls,
+                    (unsigned long long)quantile(s, 0.50), (unsigned long long)quantile(s, 0.90),
+                    (unsigned long long)quantile(s, 0.99), (unsigned long long)s.maxNs);
+    }
+
+    for (uint32 p = 1; p < stats.size(); p++) {
+        const ProcedureStats& s = stats[p];
+        if (!s.calls) continue;
+        std::printf("\n%s latency histogram\n", dispatch.procedure(p)->name.c_str());
+        uint64 peak = 0;
+        for (int b = 0; b < HISTOGRAM_BUCKETS; b++) if (s.buckets[b] > peak) peak = s.buckets[b];
+        for (int b = 0; b < HISTOGRAM_BUCKETS; b++) {
+            if (!s.buckets[b]) continue;
+            int bar = (int)(50 * s.buckets[b] / peak);
+            std::printf("  %10llu ns  %10llu  ", (unsigned long long)(1ULL << b), (unsigned long long)s.buckets[b]);
+            for (int i = 0; i < (bar ? bar : 1); i++) std::putchar('#');
+            std::putchar('\n');
+        }
+    }
+
+    std::printf("\noutput digest:                  ");
+    printHex(outputs.value());
+    std::printf("\nstate digest (layout-specific): ");
+    printHex(qm::stateDigest(*contract));
+    std::printf("\n");
+    return truncated ? 1 : 0;
+}
@@ -0,0 +1,1061 @@
+/**
+ * Unit tests for the QubicMessenger contract, run natively against the QPI shim.
+ * Run: ctest (after building with CMake)
+ */
+
+#include "qubic_messenger.h"
+#include "qubic_messenger_trace.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+using namespace QPI;
+using Contract = std::unique_ptr<QubicMessenger>;
+
+#define CHECK(cond)                                                       \
+    do {                                                                  \
+        if (!(cond)) {                                                    \
+            std::printf("FAIL %s:%d  %s\n", __FILE__, __LINE__, #cond);   \
+            std::exit(1);                                                 \
+        }                                                                 \
+    } while (0)
+
+// ─── Helpers ──────────────────────────────────────────────────────────────────
+
+// Call context the tests drive the contract with
+static QpiContext qpi;
+
+static id userId(uint64 n) {
+    id v = id::zero();
+    v.u64._0 = n * 0x9E3779B97F4A7C15ULL;
+    v.u64._1 = n;
+    return v;
+}
+
+// Zeroed on the heap: several inputs and outputs are kilobytes
+template <typename T>
+static std::unique_ptr<T> make() { return std::unique_ptr<T>(new T()); }
+
+static uint32 nextNonce[1024];
+
+static sint32 registerUser(QubicMessenger* c, const id& owner, const uint8* nickname) {
+    qpi.setInvocator(owner);
+    auto in  = make<QubicMessenger::RegisterUser_input>();
+    auto out = make<QubicMessenger::RegisterUser_output>();
+    std::memcpy(in->nickname, nickname, QM_NICKNAME_LEN);
+    c->RegisterUser(qpi, *in, *out);
+    return out->slotIndex;
+}
+
+static void nicknameOf(uint64 u, uint8* nickname) {
+    std::memset(nickname, 0, QM_NICKNAME_LEN);
+    std::snprintf((char*)nickname, QM_NICKNAME_LEN, "user%llu", (unsigned long long)u);
+}
+
+static Contract freshContract(uint64 users) {
+    Contract c = qm::createContract();
+    qpi.reset();
+    std::memset(nextNonce, 0, sizeof(nextNonce));
+    uint8 nickname[QM_NICKNAME_LEN];
+    for (uint64 u = 1; u <= users; u++) {
+        nicknameOf(u, nickname);
+        CHECK(registerUser(c.get(), userId(u), nickname) == (sint32)(u - 1));
+    }
+    return c;
+}
+
+static bool ownerFound(QubicMessenger* c, const id& owner) {
+    auto in  = make<QubicMessenger::LookupUserByOwner_input>();
+    auto out = make<QubicMessenger::LookupUserByOwner_output>();
+    in->owner = owner;
+    c->LookupUserByOwner(qpi, *in, *out);
+    return out->found;
+}
+
+static void deactivate(QubicMessenger* c, const id& owner) {
+    qpi.setInvocator(owner);
+    auto in  = make<QubicMessenger::DeactivateUser_input>();
+    auto out = make<QubicMessenger::DeactivateUser_output>();
+    c->DeactivateUser(qpi, *in, *out);
+    CHECK(out->success);
+}
+
+// contentHash = [tag, from, 0...]
+static QubicMessenger::PostMessageMeta_output postWithNonce(QubicMessenger* c, uint64 from, uint64 to, uint8 tag,
+                                                            uint32 nonce, uint8 lane) {
+    qpi.setInvocator(userId(from));
+    auto in = make<QubicMessenger::PostMessageMeta_input>();
+    in->receiver       = userId(to);
+    in->contentHash[0] = tag;
+    in->contentHash[1] = (uint8)from;
+    in->nonce          = nonce;
+    in->lane           = lane;
+    auto out = make<QubicMessenger::PostMessageMeta_output>();
+    c->PostMessageMeta(qpi, *in, *out);
+    return *out;
+}
+
+// Posts on lane 0 with the sender's next nonce
+static QubicMessenger::PostMessageMeta_output post(QubicMessenger* c, uint64 from, uint64 to, uint8 tag) {
+    return postWithNonce(c, from, to, tag, ++nextNonce[from], 0);
+}
+
+static void advance(uint32& tick, uint32 by = QM_RATE_REFILL_TICKS_FREE) {
+    tick += by;
+    qpi.setTick(tick);
+}
+
+static QubicMessenger::GetMessageMetaBySeq_output metaBySeq(QubicMessenger* c, uint64 seq) {
+    auto in  = make<QubicMessenger::GetMessageMetaBySeq_input>();
+    auto out = make<QubicMessenger::GetMessageMetaBySeq_output>();
+    in->seq = seq;
+    c->GetMessageMetaBySeq(qpi, *in, *out);
+    return *out;
+}
+
+// Every seq in receiver's inbox, newest first, following the page cursor
+static std::vector<uint64> inboxSeqs(QubicMessenger* c, uint64 receiver) {
+    auto in  = make<QubicMessenger::GetInbox_input>();
+    auto out = make<QubicMessenger::GetInbox_output>();
+    in->receiver = userId(receiver);
+    in->maxCount = 7;
+    std::vector<uint64> seqs;
+    for (;;) {
+        c->GetInbox(qpi, *in, *out);
+        for (uint32 i = 0; i < out->count; i++) {
+            CHECK(out->entries[i].receiver == userId(receiver));
+            seqs.push_back(out->entries[i].seq);
+        }
+        if (!out->nextBeforeSeq) break;
+        in->beforeSeq = out->nextBeforeSeq;
+    }
+    return seqs;
+}
+
+static id hashPair(const id& left, const id& right) {
+    QM_MmrPair pair;
+    pair.left  = left;
+    pair.right = right;
+    return qpi.K12(pair);
+}
+
+// MMR leaf recomputed from a live entry, as an off-chain verifier would
+static id leafOf(QubicMessenger* c, uint64 seq) {
+    auto meta = metaBySeq(c, seq);
+    CHECK(meta.valid);
+    QM_MmrLeaf leaf;
+    std::memset(&leaf, 0, sizeof(leaf));
+    leaf.sender   = meta.sender;
+    leaf.receiver = meta.receiver;
+    std::memcpy(leaf.contentHash, meta.contentHash, QM_HASH_LEN);
+    leaf.seq   = seq;
+    leaf.tick  = meta.tick;
+    leaf.nonce = meta.nonce;
+    leaf.kind  = meta.kind;
+    leaf.aux   = meta.leafCount;
+    return qpi.K12(leaf);
+}
+
+// Root over leaves by the same peak bagging as the contract
+static id referenceRoot(const std::vector<id>& leaves) {
+    std::vector<id> peaks;
+    uint64 n = leaves.size(), start = 0;
+    for (int h = 63; h >= 0; h--) {
+        if (!((n >> h) & 1)) continue;
+        std::vector<id> level(leaves.begin() + start, leaves.begin() + start + (1ULL << h));
+        while (level.size() > 1) {
+            std::vector<id> next;
+            for (size_t i = 0; i < level.size(); i += 2) next.push_back(hashPair(level[i], level[i + 1]));
+            level = next;
+        }
+        peaks.push_back(level[0]);
+        start += 1ULL << h;
+    }
+    if (peaks.empty()) return id::zero();
+    id acc = peaks.back();
+    for (int i = (int)peaks.size() - 2; i >= 0; i--) acc = hashPair(peaks[i], acc);
+    return acc;
+}
+
+static bool proofHolds(QubicMessenger* c, uint64 seq, const id& leaf, const id& root) {
+    auto in  = make<QubicMessenger::GetInclusionProof_input>();
+    auto out = make<QubicMessenger::GetInclusionProof_output>();
+    in->seq = seq;
+    c->GetInclusionProof(qpi, *in, *out);
+    if (!out->available) return false;
+    id acc = leaf;
+    for (uint32 h = 0; h < out->siblingCount; h++) {
+        acc = (((seq - 1) >> h) & 1) ? hashPair(out->siblings[h], acc) : hashPair(acc, out->siblings[h]);
+    }
+    CHECK(acc == out->peaks[out->peakIndex]);
+    id bagged = out->peaks[out->peakCount - 1];
+    for (int i = (int)out->peakCount - 2; i >= 0; i--) bagged = hashPair(out->peaks[i], bagged);
+    CHECK(bagged == out->root);
+    return bagged == root;
+}
+
+// ─── Registry ─────────────────────────────────────────────────────────────────
+
+static void testRegistry() {
+    Contract c = freshContract(3);
+
+    auto lookup = make<QubicMessenger::LookupUser_input>();
+    auto found  = make<QubicMessenger::LookupUser_output>();
+    std::snprintf((char*)lookup->nickname, QM_NICKNAME_LEN, "user2");
+    c->LookupUser(qpi, *lookup, *found);
+    CHECK(found->found);
+
+    // A freed nickname and slot are claimed again
+    qpi.setInvocator(userId(2));
+    auto deIn  = make<QubicMessenger::DeactivateUser_input>();
+    auto deOut = make<QubicMessenger::DeactivateUser_output>();
+    c->DeactivateUser(qpi, *deIn, *deOut);
+    CHECK(deOut->success);
+    c->LookupUser(qpi, *lookup, *found);
+    CHECK(!found->found);
+
+    qpi.setInvocator(userId(50));
+    auto reg    = make<QubicMessenger::RegisterUser_input>();
+    auto regOut = make<QubicMessenger::RegisterUser_output>();
+    std::memcpy(reg->nickname, lookup->nickname, QM_NICKNAME_LEN);
+    c->RegisterUser(qpi, *reg, *regOut);
+    CHECK(regOut->slotIndex == 1);
+    c->LookupUser(qpi, *lookup, *found);
+    CHECK(found->found);
+
+    // Pubkey rotation shows up in both lookups
+    qpi.setTick(77);
+    qpi.setInvocator(userId(1));
+    auto upIn  = make<QubicMessenger::UpdatePubkey_input>();
+    auto upOut = make<QubicMessenger::UpdatePubkey_output>();
+    std::memset(upIn->newPubkey, 0xAB, QM_PUBKEY_LEN);
+    c->UpdatePubkey(qpi, *upIn, *upOut);
+    CHECK(upOut->success && c->userLastUpdateTick[0] == 77);
+
+    auto byOwner    = make<QubicMessenger::LookupUserByOwner_input>();
+    auto byOwnerOut = make<QubicMessenger::LookupUserByOwner_output>();
+    byOwner->owner = userId(1);
+    c->LookupUserByOwner(qpi, *byOwner, *byOwnerOut);
+    CHECK(byOwnerOut->found && std::strcmp((const char*)byOwnerOut->nickname, "user1") == 0);
+    CHECK(std::memcmp(byOwnerOut->pubkey, upIn->newPubkey, QM_PUBKEY_LEN) == 0);
+    std::snprintf((char*)lookup->nickname, QM_NICKNAME_LEN, "user1");
+    c->LookupUser(qpi, *lookup, *found);
+    CHECK(found->found && std::memcmp(found->pubkey, upIn->newPubkey, QM_PUBKEY_LEN) == 0);
+
+    // Only registered owners can update, and the old owner of slot 1 is gone
+    qpi.setInvocator(userId(99));
+    c->UpdatePubkey(qpi, *upIn, *upOut);
+    CHECK(!upOut->success);
+    byOwner->owner = userId(2);
+    c->LookupUserByOwner(qpi, *byOwner, *byOwnerOut);
+    CHECK(!byOwnerOut->found);
+
+    std::printf("registry ok\n");
+}
+
+// Owners that all hash to one index position
+static id collidingOwner(uint64 n) {
+    id v = id::zero();
+    v.u64._0 = 0x5EED;
+    v.u64._1 = n;
+    return v;
+}
+
+static void testOwnerCollisions() {
+    Contract c = freshContract(0);
+    uint8 nickname[QM_NICKNAME_LEN];
+    for (uint64 n = 0; n < QM_INDEX_MAX_PROBES; n++) {
+        nicknameOf(n, nickname);
+        CHECK(registerUser(c.get(), collidingOwner(n), nickname) == (sint32)n);
+    }
+    CHECK(registerUser(c.get(), collidingOwner(0), nickname) == -3);
+
+    // A full probe window is reported as such, not as a full registry
+    const uint64 extra = QM_INDEX_MAX_PROBES;
+    nicknameOf(extra, nickname);
+    CHECK(registerUser(c.get(), collidingOwner(extra), nickname) == -4);
+    CHECK(c->userCount == QM_INDEX_MAX_PROBES && !ownerFound(c.get(), collidingOwner(extra)));
+    nicknameOf(1000, nickname);
+    CHECK(registerUser(c.get(), userId(1000), nickname) == QM_INDEX_MAX_PROBES);
+
+    // Erasing from the middle of the run keeps the rest of it reachable
+    for (uint64 n = 20; n < 40; n += 3) deactivate(c.get(), collidingOwner(n));
+    for (uint64 n = 0; n < QM_INDEX_MAX_PROBES; n++) {
+        bool erased = n >= 20 && n < 40 && (n - 20) % 3 == 0;
+        CHECK(ownerFound(c.get(), collidingOwner(n)) == !erased);
+    }
+    nicknameOf(extra, nickname);
+    CHECK(registerUser(c.get(), collidingOwner(extra), nickname) >= 0);
+    CHECK(ownerFound(c.get(), collidingOwner(extra)));
+    std::printf("owner collisions ok\n");
+}
+
+// Owner whose index home position is `home`
+static id ownerAtHome(uint32 home, uint64 n) {
+    id v = id::zero();
+    v.u64._0 = home;
+    v.u64._1 = n + 1;
+    return v;
+}
+
+static uint32 tombstones(const QubicMessenger* c) {
+    uint32 n = 0;
+    for (uint32 pos = 0; pos < QM_USER_INDEX_SIZE; pos++) n += c->ownerIndex[pos] == QM_INDEX_TOMBSTONE;
+    return n;
+}
+
+static void testIndexShiftBudget() {
+    // A run longer than QM_INDEX_SHIFT_BUDGET where every entry sits one past
+    // its home: two keys at home 1000, then one per home from 1001 on
+    Contract c = freshContract(0);
+    uint8 nickname[QM_NICKNAME_LEN];
+    const uint32 first = 1000, homes = QM_INDEX_SHIFT_BUDGET + 44;
+    std::vector<id> owners = { ownerAtHome(first, 0), ownerAtHome(first, 1) };
+    for (uint32 h = first + 1; h < first + homes; h++) owners.push_back(ownerAtHome(h, 0));
+    for (uint64 i = 0; i < owners.size(); i++) {
+        nicknameOf(i, nickname);
+        CHECK(registerUser(c.get(), owners[i], nickname) == (sint32)i);
+    }
+
+    // Erasing the head shifts every later entry back until the budget runs
+    // out, then leaves a tombstone so the tail stays reachable
+    deactivate(c.get(), owners[0]);
+    CHECK(tombstones(c.get()) == 1);
+    const uint32 tombstone = first + QM_INDEX_SHIFT_BUDGET;
+    CHECK(c->ownerIndex[tombstone] == QM_INDEX_TOMBSTONE);
+    for (uint64 i = 1; i < owners.size(); i++) CHECK(ownerFound(c.get(), owners[i]));
+
+    // Later erases and reinserts around the tombstone still work
+    deactivate(c.get(), owners[owners.size() - 10]);
+    for (uint64 i = 1; i < owners.size(); i++) CHECK(ownerFound(c.get(), owners[i]) == (i != owners.size() - 10));
+    nicknameOf(9000, nickname);
+    CHECK(registerUser(c.get(), ownerAtHome(tombstone, 7), nickname) >= 0);
+    CHECK(c->ownerIndex[tombstone] != QM_INDEX_TOMBSTONE && tombstones(c.get()) == 0);
+    CHECK(ownerFound(c.get(), ownerAtHome(tombstone, 7)));
+    for (uint64 i = 1; i < owners.size(); i++) CHECK(ownerFound(c.get(), owners[i]) == (i != owners.size() - 10));
+    nicknameOf(9001, nickname);
+    CHECK(registerUser(c.get(), owners[owners.size() - 10], nickname) >= 0);
+    CHECK(ownerFound(c.get(), owners[owners.size() - 10]));
+    std::printf("index shift budget ok\n");
+}
+
+static bool nicknameFound(QubicMessenger* c, const uint8* nickname) {
+    auto in  = make<QubicMessenger::LookupUser_input>();
+    auto out = make<QubicMessenger::LookupUser_output>();
+    std::memcpy(in->nickname, nickname, QM_NICKNAME_LEN);
+    c->LookupUser(qpi, *in, *out);
+    return out->found;
+}
+
+static void testNicknameCollisions() {
+    // Grind nicknames onto one home position, as an attacker would offline
+    std::vector<std::vector<uint8>> names;
+    uint8 nickname[QM_NICKNAME_LEN];
+    for (uint64 n = 0; names.size() < QM_INDEX_MAX_PROBES + 1; n++) {
+        nicknameOf(n, nickname);
+        if (QubicMessenger::_hashNickname(nickname) % QM_USER_INDEX_SIZE == 7) {
+            names.emplace_back(nickname, nickname + QM_NICKNAME_LEN);
+        }
+    }
+
+    Contract c = freshContract(0);
+    for (uint64 i = 0; i < QM_INDEX_MAX_PROBES; i++) {
+        CHECK(registerUser(c.get(), userId(1000 + i), names[i].data()) == (sint32)i);
+    }
+    CHECK(registerUser(c.get(), userId(5000), names[10].data()) == -1);
+
+    // The rejected registration leaves no owner entry behind
+    CHECK(registerUser(c.get(), userId(5000), names.back().data()) == -4);
+    CHECK(!ownerFound(c.get(), userId(5000)) && !nicknameFound(c.get(), names.back().data()));
+
+    for (uint64 i = 20; i < 40; i += 2) deactivate(c.get(), userId(1000 + i));
+    for (uint64 i = 0; i < QM_INDEX_MAX_PROBES; i++) {
+        bool erased = i >= 20 && i < 40 && i % 2 == 0;
+        CHECK(nicknameFound(c.get(), names[i].data()) == !erased);
+    }
+    CHECK(registerUser(c.get(), userId(5000), names.back().data()) >= 0);
+    CHECK(nicknameFound(c.get(), names.back().data()));
+    std::printf("nickname collisions ok\n");
+}
+
+// ─── Nonces And Rate Limits ───────────────────────────────────────────────────
+
+static uint8 postCode(QubicMessenger* c, uint32& tick, uint32 nonce, uint8 lane = 0) {
+    advance(tick);
+    auto out = postWithNonce(c, 1, 2, (uint8)nonce, nonce, lane);
+    return out.success ? 0 : out.errorCode;
+}
+
+static void testNonceWindow() {
+    Contract c = freshContract(2);
+    uint32 t = 1000;
+    CHECK(postCode(c.get(), t, 0) == 2);    // nonce 0 is never valid
+    CHECK(postCode(c.get(), t, 5) == 0);
+    CHECK(postCode(c.get(), t, 3) == 0);    // out of order
+    CHECK(postCode(c.get(), t, 3) == 2);    // duplicate
+    CHECK(postCode(c.get(), t, 100) == 0);
+    CHECK(postCode(c.get(), t, 37) == 0);   // 63 below the max
+    CHECK(postCode(c.get(), t, 36) == 2);   // 64 below: outside the window
+    std::printf("nonce window ok\n");
+}
+
+static void testDeviceLanes() {
+    Contract c = freshContract(2);
+    uint32 t = 1000;
+    CHECK(postCode(c.get(), t, 1, 1) == 9);
+
+    auto in  = make<QubicMessenger::AddDeviceLane_input>();
+    auto out = make<QubicMessenger::AddDeviceLane_output>();
+    qpi.setInvocator(userId(1));
+    c->AddDeviceLane(qpi, *in, *out);
+    CHECK(out->success && out->lane == 1);
+
+    // Lanes keep separate windows
+    CHECK(postCode(c.get(), t, 1, 0) == 0);
+    CHECK(postCode(c.get(), t, 1, 1) == 0);
+    CHECK(postCode(c.get(), t, 1, 1) == 2);
+    CHECK(postCode(c.get(), t, 200, 0) == 0);
+    CHECK(postCode(c.get(), t, 2, 1) == 0);
+
+    for (uint8 lane = 2; lane < QM_MAX_LANES; lane++) {
+        c->AddDeviceLane(qpi, *in, *out);
+        CHECK(out->success && out->lane == lane);
+    }
+    c->AddDeviceLane(qpi, *in, *out);
+    CHECK(!out->success && out->errorCode == 9);
+    std::printf("device lanes ok\n");
+}
+
+static void testRateTiers() {
+    Contract c = freshContract(2);
+    uint32 t = 1000;
+    qpi.setTick(t);
+
+    // A full free bucket, then one token per refill interval
+    for (int i = 0; i < QM_RATE_CAPACITY_FREE; i++) CHECK(post(c.get(), 1, 2, 0).success);
+    CHECK(post(c.get(), 1, 2, 0).errorCode == 3);
+    advance(t, QM_RATE_REFILL_TICKS_FREE);
+    CHECK(post(c.get(), 1, 2, 0).success);
+
+    // The balance is only read again in the next epoch
+    qpi.setBalance(userId(1), QM_TIER_GOLD_MIN_BALANCE);
+    advance(t, 1000);
+    for (int i = 0; i < QM_RATE_CAPACITY_FREE; i++) CHECK(post(c.get(), 1, 2, 0).success);
+    CHECK(post(c.get(), 1, 2, 0).errorCode == 3);
+
+    qpi.setEpoch(1);
+    advance(t, 1000);
+    for (int i = 0; i < QM_RATE_CAPACITY_GOLD; i++) CHECK(post(c.get(), 1, 2, 0).success);
+    CHECK(post(c.get(), 1, 2, 0).errorCode == 3);
+    CHECK(c->userTier[0] == QM_TIER_GOLD);
+
+    // Dropping a tier clamps the bucket
+    advance(t, 1000);
+    qpi.setBalance(userId(1), 0);
+    qpi.setEpoch(2);
+    CHECK(post(c.get(), 1, 2, 0).success);
+    CHECK(c->userTier[0] == QM_TIER_FREE && c->rateTokens[0] == QM_RATE_CAPACITY_FREE - 1);
+    std::printf("rate tiers ok\n");
+}
+
+// ─── Log, Inbox And Proofs ────────────────────────────────────────────────────
+
+static void testInboxAcrossWrap() {
+    Contract c = freshContract(6);
+    uint32 t = 100;
+    std::vector<uint64> expected;
+    for (int i = 0; i < 600; i++) {
+        advance(t);
+        uint64 to = (i % 3 == 0) ? 2 : (i % 3 == 1) ? 4 : 99;  // 99 is unregistered
+        auto out = post(c.get(), (i % 2) ? 1 : 3, to, (uint8)i);
+        CHECK(out.success);
+        if (to == 2) expected.push_back(out.seq);
+    }
+    std::vector<uint64> newestFirst(expected.rbegin(), expected.rend());
+    CHECK(inboxSeqs(c.get(), 2) == newestFirst);
+
+    auto headIn  = make<QubicMessenger::GetInboxHead_input>();
+    auto headOut = make<QubicMessenger::GetInboxHead_output>();
+    headIn->receiver = userId(2);
+    c->GetInboxHead(qpi, *headIn, *headOut);
+    CHECK(headOut->found && headOut->latestSeq == expected.back() && headOut->totalCount == expected.size());
+
+    // Once the ring wraps the old entries are gone and the chain says so
+    for (int i = 0; i < QM_MSG_LOG_SIZE + 100; i++) {
+        advance(t);
+        CHECK(post(c.get(), 5, 4, (uint8)i).success);
+    }
+    auto in  = make<QubicMessenger::GetInbox_input>();
+    auto out = make<QubicMessenger::GetInbox_output>();
+    in->receiver = userId(2);
+    in->maxCount = 8;
+    c->GetInbox(qpi, *in, *out);
+    CHECK(out->count == 0 && out->truncated);
+    CHECK(!metaBySeq(c.get(), 1).valid);
+    std::printf("inbox ok\n");
+}
+
+// Tick of seq in testRangeReads, which advances the clock before every post
+static uint32 tickOfSeq(uint64 seq) { return 100 + QM_RATE_REFILL_TICKS_FREE * (uint32)seq; }
+
+static void testRangeReads() {
+    Contract c = freshContract(3);
+    uint32 t = 100;
+    const uint64 total = QM_MSG_LOG_SIZE + 100;
+    for (uint64 i = 0; i < total; i++) {
+        advance(t);
+        CHECK(post(c.get(), 1 + i % 2, 3, (uint8)i).success);
+    }
+    const uint64 oldest = total - QM_MSG_LOG_SIZE + 1;
+
+    // Sequential paging from the start of history skips the evicted prefix once
+    auto range    = make<QubicMessenger::GetMessageMetaRange_input>();
+    auto rangeOut = make<QubicMessenger::GetMessageMetaRange_output>();
+    range->startSeq = 1;
+    range->count    = QM_RANGE_MAX;
+    c->GetMessageMetaRange(qpi, *range, *rangeOut);
+    CHECK(rangeOut->evicted == oldest - 1 && rangeOut->count == QM_RANGE_MAX);
+    CHECK(rangeOut->entries[0].seq == oldest && rangeOut->nextSeq == oldest + QM_RANGE_MAX);
+
+    uint64 expected = oldest;
+    range->startSeq = oldest;
+    for (;;) {
+        c->GetMessageMetaRange(qpi, *range, *rangeOut);
+        CHECK(rangeOut->evicted == 0);
+        if (rangeOut->count == 0) break;
+        for (uint32 i = 0; i < rangeOut->count; i++, expected++) {
+            CHECK(rangeOut->entries[i].seq == expected && rangeOut->entries[i].tick == tickOfSeq(expected));
+        }
+        range->startSeq = rangeOut->nextSeq;
+    }
+    CHECK(expected == total + 1 && rangeOut->nextSeq == total + 1);
+
+    // A tick window that straddles the ring's wrap point, in two pages
+    auto ticks    = make<QubicMessenger::GetMessagesByTickRange_input>();
+    auto ticksOut = make<QubicMessenger::GetMessagesByTickRange_output>();
+    ticks->fromTick = tickOfSeq(QM_MSG_LOG_SIZE - 40);
+    ticks->toTick   = tickOfSeq(QM_MSG_LOG_SIZE + 60);
+    c->GetMessagesByTickRange(qpi, *ticks, *ticksOut);
+    CHECK(!ticksOut->evicted && ticksOut->count == QM_RANGE_MAX);
+    CHECK(ticksOut->entries[0].seq == QM_MSG_LOG_SIZE - 40 && ticksOut->nextSeq == QM_MSG_LOG_SIZE + 24);
+    ticks->startSeq = ticksOut->nextSeq;
+    c->GetMessagesByTickRange(qpi, *ticks, *ticksOut);
+    CHECK(!ticksOut->evicted && ticksOut->count == 37 && ticksOut->nextSeq == 0);
+    CHECK(ticksOut->entries[36].seq == QM_MSG_LOG_SIZE + 60);
+
+    // A window reaching before the oldest live entry is flagged
+    ticks->fromTick = tickOfSeq(1);
+    ticks->toTick   = tickOfSeq(oldest + 9);
+    ticks->startSeq = 0;
+    c->GetMessagesByTickRange(qpi, *ticks, *ticksOut);
+    CHECK(ticksOut->evicted && ticksOut->count == 10 && ticksOut->entries[0].seq == oldest);
+
+    // So is a cursor the ring has overtaken between pages
+    ticks->toTick = tickOfSeq(oldest + 200);
+    c->GetMessagesByTickRange(qpi, *ticks, *ticksOut);
+    CHECK(ticksOut->count == QM_RANGE_MAX && ticksOut->nextSeq == oldest + QM_RANGE_MAX);
+    for (int i = 0; i < 100; i++) {
+        advance(t);
+        CHECK(post(c.get(), 1, 3, 0).success);
+    }
+    ticks->startSeq = ticksOut->nextSeq;
+    c->GetMessagesByTickRange(qpi, *ticks, *ticksOut);
+    CHECK(ticksOut->evicted && ticksOut->entries[0].seq == oldest + 100);
+
+    // Outbox pages hold only the sender's entries, newest first
+    auto outbox  = make<QubicMessenger::GetOutbox_input>();
+    auto outPage = make<QubicMessenger::GetOutbox_output>();
+    outbox->sender   = userId(2);
+    outbox->maxCount = 5;
+    c->GetOutbox(qpi, *outbox, *outPage);
+    CHECK(outPage->count == 5 && !outPage->truncated);
+    uint64 newest = total % 2 == 0 ? total : total - 1;  // user 2 posted the even seqs
+    for (uint32 i = 0; i < outPage->count; i++) {
+        CHECK(outPage->entries[i].seq == newest - 2 * i && outPage->entries[i].sender == userId(2));
+    }
+    CHECK(outPage->nextBeforeSeq == newest - 8);
+    outbox->beforeSeq = outPage->nextBeforeSeq;
+    c->GetOutbox(qpi, *outbox, *outPage);
+    CHECK(outPage->count == 5 && outPage->entries[0].seq == newest - 10);
+    std::printf("range reads ok\n");
+}
+
+static void testBatch() {
+    Contract c = freshContract(4);
+    qpi.setTick(100);
+    qpi.setInvocator(userId(1));
+    auto in  = make<QubicMessenger::PostMessageMetaBatch_input>();
+    auto out = make<QubicMessenger::PostMessageMetaBatch_output>();
+    uint64 to[5]     = {2, 1, 3, 99, 4};   // 1 is the sender, 99 unregistered
+    uint32 nonces[5] = {1, 2, 1, 3, 4};    // entry 2 repeats entry 0's nonce
+    for (uint32 i = 0; i < 5; i++) {
+        in->receivers[i]        = userId(to[i]);
+        in->contentHashes[i][0] = (uint8)(0x10 + i);
+        in->nonces[i]           = nonces[i];
+    }
+    in->count = 5;
+    c->PostMessageMetaBatch(qpi, *in, *out);
+    CHECK(out->errorCode == 0 && out->accepted == 3);
+    uint8 errors[5] = {0, 4, 2, 0, 0};
+    for (uint32 i = 0; i < 5; i++) CHECK(out->entryErrors[i] == errors[i]);
+    CHECK(out->seqs[0] == 1 && out->seqs[1] == 0 && out->seqs[2] == 0 && out->seqs[3] == 2 && out->seqs[4] == 3);
+    CHECK(metaBySeq(c.get(), 2).receiver == userId(99) && metaBySeq(c.get(), 3).contentHash[0] == 0x14);
+
+    // The whole batch spent one token; a batch with nothing accepted spends none
+    CHECK(c->rateTokens[0] == QM_RATE_CAPACITY_FREE - 1);
+    c->PostMessageMetaBatch(qpi, *in, *out);
+    CHECK(out->errorCode == 0 && out->accepted == 0 && out->entryErrors[0] == 2);
+    CHECK(c->rateTokens[0] == QM_RATE_CAPACITY_FREE - 1);
+
+    in->count = 0;
+    c->PostMessageMetaBatch(qpi, *in, *out);
+    CHECK(out->errorCode == 6);
+    std::printf("batch ok\n");
+}
+
+static void testUnregisteredReceivers() {
+    Contract c = freshContract(2);
+    uint32 t = 100;
+    for (uint64 i = 0; i < QM_EXT_ID_SIZE; i++) {
+        advance(t);
+        auto out = post(c.get(), 1, 10000 + i, (uint8)i);
+        CHECK(out.success);
+        CHECK(metaBySeq(c.get(), out.seq).receiver == userId(10000 + i));
+    }
+
+    // A full table rejects new unregistered ids without touching the log,
+    // while interned ids and registered users are still accepted
+    uint64 seq = c->msgSeq;
+    advance(t);
+    CHECK(post(c.get(), 1, 90000, 0).errorCode == 5);
+    CHECK(c->msgSeq == seq);
+    CHECK(post(c.get(), 1, 10000, 0).success);
+    CHECK(post(c.get(), 1, 2, 0).success);
+
+    qpi.setInvocator(userId(1));
+    auto in  = make<QubicMessenger::PostMessageMetaBatch_input>();
+    auto out = make<QubicMessenger::PostMessageMetaBatch_output>();
+    in->receivers[0] = userId(90000);
+    in->receivers[1] = userId(2);
+    in->nonces[0]    = ++nextNonce[1];
+    in->nonces[1]    = ++nextNonce[1];
+    in->count        = 2;
+    advance(t);
+    c->PostMessageMetaBatch(qpi, *in, *out);
+    CHECK(out->accepted == 1 && out->entryErrors[0] == 5 && out->entryErrors[1] == 0);
+
+    // Evicting the entries that named them frees their ids again
+    for (uint64 i = 0; i < QM_MSG_LOG_SIZE; i++) {
+        advance(t);
+        CHECK(post(c.get(), 1, 2, (uint8)i).success);
+    }
+    advance(t);
+    CHECK(post(c.get(), 1, 90000, 0).success);
+    std::printf("unregistered receivers ok\n");
+}
+
+static void testDeliveryIndex() {
+    Contract c = freshContract(3);
+    uint32 t = 100;
+    advance(t);
+    auto posted = post(c.get(), 1, 2, 0x42);
+    CHECK(posted.success);
+
+    auto in  = make<QubicMessenger::VerifyDelivery_input>();
+    auto out = make<QubicMessenger::VerifyDelivery_output>();
+    in->contentHash[0] = 0x42;
+    in->contentHash[1] = 1;
+    c->VerifyDelivery(qpi, *in, *out);
+    CHECK(out->found && out->seq == posted.seq && out->sender == userId(1) && out->receiver == userId(2));
+
+    in->contentHash[0] = 0x43;
+    c->VerifyDelivery(qpi, *in, *out);
+    CHECK(!out->found);
+
+    // Re-posting a public content hash does not take over the proof
+    qpi.setInvocator(userId(3));
+    auto repost    = make<QubicMessenger::PostMessageMeta_input>();
+    auto repostOut = make<QubicMessenger::PostMessageMeta_output>();
+    repost->receiver       = userId(1);
+    repost->contentHash[0] = 0x42;
+    repost->contentHash[1] = 1;
+    repost->nonce          = 1;
+    c->PostMessageMeta(qpi, *repost, *repostOut);
+    CHECK(repostOut->success);
+    in->contentHash[0] = 0x42;
+    c->VerifyDelivery(qpi, *in, *out);
+    CHECK(out->found && out->seq == posted.seq && out->sender == userId(1) && out->receiver == userId(2));
+
+    // Entries sharing a hash are told apart by sender and receiver
+    advance(t);
+    auto second = post(c.get(), 1, 3, 0x42);
+    CHECK(second.success);
+    in->receiver = userId(3);
+    c->VerifyDelivery(qpi, *in, *out);
+    CHECK(out->found && out->seq == second.seq && out->sender == userId(1) && out->receiver == userId(3));
+    in->receiver = userId(2);
+    c->VerifyDelivery(qpi, *in, *out);
+    CHECK(out->found && out->seq == posted.seq);
+    in->sender   = userId(3);
+    in->receiver = userId(1);
+    c->VerifyDelivery(qpi, *in, *out);
+    CHECK(out->found && out->seq == repostOut->seq);
+    in->receiver = userId(2);
+    c->VerifyDelivery(qpi, *in, *out);
+    CHECK(!out->found && !out->truncated);
+    in->sender   = id::zero();
+    in->receiver = id::zero();
+
+    // A new epoch draws a new seed and rebuilds the index without losing order
+    uint64 seed = c->hashSeed;
+    qpi.setEpoch(1);
+    advance(t);
+    CHECK(post(c.get(), 2, 1, 0).success);
+    CHECK(c->hashSeed != seed && c->hashSeedEpoch == 1);
+    c->VerifyDelivery(qpi, *in, *out);
+    CHECK(out->found && out->seq == posted.seq && out->sender == userId(1) && out->receiver == userId(2));
+
+    // Once the original is evicted the next live entry with the hash answers
+    while (c->msgSeq < QM_MSG_LOG_SIZE + posted.seq) {
+        advance(t);
+        CHECK(post(c.get(), 2, 1, 0).success);
+    }
+    c->VerifyDelivery(qpi, *in, *out);
+    CHECK(out->found && out->seq == repostOut->seq && out->sender == userId(3) && out->receiver == userId(1));
+    advance(t);
+    CHECK(post(c.get(), 2, 1, 0).success);
+    c->VerifyDelivery(qpi, *in, *out);
+    CHECK(out->found && out->seq == second.seq);
+    advance(t);
+    CHECK(post(c.get(), 2, 1, 0).success);
+    c->VerifyDelivery(qpi, *in, *out);
+    CHECK(!out->found);
+    std::printf("delivery index ok\n");
+}
+
+static void testMerkleLog() {
+    Contract c = freshContract(40);
+    uint32 t = 100;
+    std::vector<id> leaves;
+
+    auto rootIn  = make<QubicMessenger::GetLogRoot_input>();
+    auto rootOut = make<QubicMessenger::GetLogRoot_output>();
+    c->GetLogRoot(qpi, *rootIn, *rootOut);
+    CHECK(rootOut->root == id::zero());
+
+    for (int i = 0; i < 300; i++) {
+        advance(t);
+        auto out = post(c.get(), 1 + i % 40, 1 + (i + 1) % 40, (uint8)i);
+        CHECK(out.success);
+        leaves.push_back(leafOf(c.get(), out.seq));
+
+        c->GetLogRoot(qpi, *rootIn, *rootOut);
+        CHECK(rootOut->leafCount == leaves.size() && rootOut->root == referenceRoot(leaves));
+    }
+    for (uint64 seq = 1; seq <= leaves.size(); seq++) {
+        CHECK(proofHolds(c.get(), seq, leaves[seq - 1], rootOut->root));
+    }
+
+    // Segment roots equal the subtree over their leaves
+    for (int i = 0; i < 2 * QM_SEGMENT_SIZE; i++) {
+        advance(t);
+        auto out = post(c.get(), 1 + i % 40, 1 + (i + 1) % 40, (uint8)i);
+        CHECK(out.success);
+        leaves.push_back(leafOf(c.get(), out.seq));
+    }
+    auto segIn  = make<QubicMessenger::GetSegmentRoot_input>();
+    auto segOut = make<QubicMessenger::GetSegmentRoot_output>();
+    for (uint64 k = 0; k < 2; k++) {
+        segIn->segment = k;
+        c->GetSegmentRoot(qpi, *segIn, *segOut);
+        std::vector<id> sub(leaves.begin() + k * QM_SEGMENT_SIZE, leaves.begin() + (k + 1) * QM_SEGMENT_SIZE);
+        CHECK(segOut->found && segOut->firstSeq == k * QM_SEGMENT_SIZE + 1 && segOut->root == referenceRoot(sub));
+    }
+    std::printf("merkle log ok\n");
+}
+
+static void testMulticast() {
+    Contract c = freshContract(25);
+    uint32 t = 100;
+    advance(t);
+
+    qpi.setInvocator(userId(1));
+    auto in  = make<QubicMessenger::PostMulticastMeta_input>();
+    auto out = make<QubicMessenger::PostMulticastMeta_output>();
+    for (uint8 i = 0; i < 20; i++) in->receivers[i] = userId(2 + i);
+    in->receivers[20] = userId(1);      // yourself
+    in->receivers[21] = userId(500);    // unregistered
+    in->receivers[22] = userId(3);      // duplicate
+    in->count = 23;
+    in->contentHash[0] = 0xC0;
+    in->nonce = 1;
+    c->PostMulticastMeta(qpi, *in, *out);
+    CHECK(out->success && out->linked == 20 && out->skippedMask == ((1u << 20) | (1u << 21) | (1u << 22)));
+
+    for (uint64 u = 2; u <= 21; u++) CHECK(inboxSeqs(c.get(), u) == std::vector<uint64>{out->seq});
+    CHECK(metaBySeq(c.get(), out->seq).kind == QM_KIND_MULTICAST);
+
+    auto listIn  = make<QubicMessenger::GetMulticastReceivers_input>();
+    auto listOut = make<QubicMessenger::GetMulticastReceivers_output>();
+    listIn->seq = out->seq;
+    c->GetMulticastReceivers(qpi, *listIn, *listOut);
+    CHECK(listOut->found && listOut->count == 20);
+    for (uint32 i = 0; i < 20; i++) CHECK(listOut->receivers[i] == userId(2 + i));
+
+    // Every receiver of the run can be shown, but not the skipped one
+    auto proofIn  = make<QubicMessenger::VerifyDelivery_input>();
+    auto proofOut = make<QubicMessenger::VerifyDelivery_output>();
+    proofIn->contentHash[0] = 0xC0;
+    proofIn->receiver = userId(21);
+    c->VerifyDelivery(qpi, *proofIn, *proofOut);
+    CHECK(proofOut->found && proofOut->seq == out->seq && proofOut->receiver == userId(21) &&
+          proofOut->kind == QM_KIND_MULTICAST);
+    proofIn->receiver = userId(500);
+    c->VerifyDelivery(qpi, *proofIn, *proofOut);
+    CHECK(!proofOut->found);
+    advance(t);
+    listIn->seq = post(c.get(), 1, 2, 0).seq;
+    c->GetMulticastReceivers(qpi, *listIn, *listOut);
+    CHECK(!listOut->found && listOut->count == 0);
+    std::printf("multicast ok\n");
+}
+
+// Multicast from user 1 to users [first, first + count)
+static QubicMessenger::PostMulticastMeta_output multicast(QubicMessenger* c, uint64 first, uint8 count, uint8 tag) {
+    qpi.setInvocator(userId(1));
+    auto in = make<QubicMessenger::PostMulticastMeta_input>();
+    for (uint8 i = 0; i < count; i++) in->receivers[i] = userId(first + i);
+    in->count          = count;
+    in->contentHash[0] = tag;
+    in->nonce          = ++nextNonce[1];
+    auto out = make<QubicMessenger::PostMulticastMeta_output>();
+    c->PostMulticastMeta(qpi, *in, *out);
+    return *out;
+}
+
+static void testMulticastRingFull() {
+    Contract c = freshContract(QM_MCAST_MAX_RECEIVERS + 1);
+    uint32 t = 100;
+    const uint32 fullRuns = QM_MCAST_RING_SIZE / QM_MCAST_MAX_RECEIVERS;
+    for (uint32 i = 0; i < fullRuns; i++) {
+        advance(t);
+        auto out = multicast(c.get(), 2, QM_MCAST_MAX_RECEIVERS, (uint8)i);
+        CHECK(out.success && !out.fanout);
+    }
+
+    // No room for another run: one direct entry per receiver instead
+    advance(t);
+    auto out = multicast(c.get(), 2, QM_MCAST_MAX_RECEIVERS, 0xEE);
+    CHECK(out.success && out.fanout && out.linked == QM_MCAST_MAX_RECEIVERS);
+    CHECK(c->msgSeq == out.seq + QM_MCAST_MAX_RECEIVERS - 1);
+    for (uint64 i = 0; i < QM_MCAST_MAX_RECEIVERS; i++) {
+        auto meta = metaBySeq(c.get(), out.seq + i);
+        CHECK(meta.kind == QM_KIND_DIRECT && meta.receiver == userId(2 + i) && meta.contentHash[0] == 0xEE);
+    }
+    auto in   = make<QubicMessenger::GetInbox_input>();
+    auto page = make<QubicMessenger::GetInbox_output>();
+    in->receiver = userId(2);
+    in->maxCount = 2;
+    c->GetInbox(qpi, *in, *page);
+    CHECK(page->count == 2 && page->entries[0].seq == out.seq && page->entries[1].seq == out.seq - 1);
+
+    // Multicast-only traffic never stalls: fanouts wrap the log, evicting
+    // old runs, and runs are used again once there is room
+    uint32 fanouts = 1, runs = 0;
+    for (uint32 i = 0; i < 3 * fullRuns; i++) {
+        advance(t);
+        out = multicast(c.get(), 2, QM_MCAST_MAX_RECEIVERS, (uint8)i);
+        CHECK(out.success);
+        if (out.fanout) fanouts++;
+        else runs++;
+    }
+    CHECK(fanouts > 1 && runs > fullRuns && c->msgSeq > QM_MSG_LOG_SIZE);
+    CHECK(c->mcastHead - c->mcastTail <= QM_MCAST_RING_SIZE);
+    std::printf("multicast ring full ok\n");
+}
+
+static void testBatchRoot() {
+    Contract c = freshContract(3);
+    uint32 t = 100;
+    advance(t);
+
+    // Two leaves: root = K12(leaf0 || leaf1)
+    id leaves[2];
+    for (uint32 i = 0; i < 2; i++) {
+        QM_BatchLeaf leaf;
+        std::memset(&leaf, 0, sizeof(leaf));
+        leaf.receiver       = userId(2 + i);
+        leaf.contentHash[0] = (uint8)i;
+        leaf.nonce          = i;
+        leaves[i] = qpi.K12(leaf);
+    }
+    id root = hashPair(leaves[0], leaves[1]);
+
+    qpi.setInvocator(userId(1));
+    auto in  = make<QubicMessenger::PostBatchRoot_input>();
+    auto out = make<QubicMessenger::PostBatchRoot_output>();
+    std::memcpy(in->root, root.m256i_u8, QM_HASH_LEN);
+    in->leafCount = 2;
+    in->nonce     = 1;
+    c->PostBatchRoot(qpi, *in, *out);
+    CHECK(out->success);
+
+    auto vIn  = make<QubicMessenger::VerifyBatchLeaf_input>();
+    auto vOut = make<QubicMessenger::VerifyBatchLeaf_output>();
+    vIn->rootSeq   = out->seq;
+    vIn->leafIndex = 1;
+    vIn->receiver  = userId(3);
+    vIn->contentHash[0] = 1;
+    vIn->nonce     = 1;
+    vIn->path[0]   = leaves[0];
+    c->VerifyBatchLeaf(qpi, *vIn, *vOut);
+    CHECK(vOut->valid && vOut->sender == userId(1) && vOut->leafCount == 2);
+
+    vIn->nonce = 2;
+    c->VerifyBatchLeaf(qpi, *vIn, *vOut);
+    CHECK(!vOut->valid && vOut->errorCode == 3);
+    std::printf("batch root ok\n");
+}
+
+// ─── Dispatch ─────────────────────────────────────────────────────────────────
+
+static void testDispatcher() {
+    Contract c = freshContract(2);
+    qm::Dispatcher dispatch(*c, qpi);
+    CHECK(dispatch.procedure(4) && dispatch.procedure(4)->name == "PostMessageMeta");
+    CHECK(dispatch.function(0) && dispatch.function(0)->name == "LookupUser");
+    CHECK(!dispatch.procedure(0) && !dispatch.procedure((uint32)dispatch.procedures().size() + 1));
+
+    // Same wire layout as qubic-client.ts: [32 receiver][32 contentHash][4 nonce][1 lane]
+    uint8 input[69] = {};
+    id receiver = userId(2);
+    std::memcpy(input, receiver.m256i_u8, 32);
+    input[32] = 0x77;
+    input[64] = 1;
+    std::vector<uint8> output;
+    qpi.setTick(10);
+    qpi.setInvocator(userId(1));
+    CHECK(dispatch.invokeProcedure(4, input, sizeof(input), output));
+    CHECK(output.size() == sizeof(QubicMessenger::PostMessageMeta_output) && output[0] == 1);
+
+    uint64 seq = 1;
+    CHECK(dispatch.invokeFunction(3, (const uint8*)&seq, sizeof(seq), output));
+    QubicMessenger::GetMessageMetaBySeq_output meta;
+    std::memcpy(&meta, output.data(), sizeof(meta));
+    CHECK(meta.valid && meta.sender == userId(1) && meta.contentHash[0] == 0x77);
+    std::printf("dispatcher ok\n");
+}
+
+// ─── Trace Replay ─────────────────────────────────────────────────────────────
+
+static qm::TraceRecord registerRecord(uint64 user, uint32 tick) {
+    qm::TraceRecord r;
+    r.tick      = tick;
+    r.procedure = 1;  // RegisterUser
+    r.invocator = userId(user);
+    r.input.assign(2 * QM_NICKNAME_LEN, 0);
+    std::snprintf((char*)r.input.data(), QM_NICKNAME_LEN, "user%llu", (unsigned long long)user);
+    return r;
+}
+
+static qm::TraceRecord postRecord(uint64 from, uint64 to, uint32 nonce, uint32 tick) {
+    qm::TraceRecord r;
+    r.tick      = tick;
+    r.procedure = 4;  // PostMessageMeta: [32 receiver][32 contentHash][4 nonce][1 lane]
+    r.invocator = userId(from);
+    r.input.assign(69, 0);
+    id receiver = userId(to);
+    std::memcpy(r.input.data(), receiver.m256i_u8, 32);
+    std::memcpy(r.input.data() + 32, &nonce, 4);
+    std::memcpy(r.input.data() + 64, &nonce, 4);
+    return r;
+}
+
+// Replays the trace on a zeroed contract and returns the output digest
+static id replay(std::FILE* trace) {
+    std::rewind(trace);
+    qm::TraceReader reader(trace);
+    CHECK(reader.ok());
+    Contract c = qm::createContract();
+    qm::Dispatcher dispatch(*c, qpi);
+    qpi.reset();
+    qm::TraceRecord record;
+    std::vector<uint8> output;
+    qm::OutputDigest outputs;
+    uint32 registered = 0, posted = 0;
+    while (reader.next(record)) {
+        CHECK(qm::applyRecord(dispatch, record, output));
+        outputs.add(record.procedure, output);
+        if (record.procedure == 1) {
+            QubicMessenger::RegisterUser_output out;
+            CHECK(output.size() == sizeof(out));
+            std::memcpy(&out, output.data(), sizeof(out));
+            CHECK(out.slotIndex >= 0);
+            registered++;
+        } else {
+            QubicMessenger::PostMessageMeta_output out;
+            CHECK(record.procedure == 4 && output.size() == sizeof(out));
+            std::memcpy(&out, output.data(), sizeof(out));
+            CHECK(out.success && out.seq == posted + 1);
+            posted++;
+        }
+    }
+    CHECK(reader.ok() && registered == 3 && posted == 200);
+    return outputs.value();
+}
+
+static void testTraceReplay() {
+    std::FILE* trace = std::tmpfile();
+    CHECK(trace);
+    qm::TraceWriter writer(trace);
+    CHECK(writer.ok());
+    for (uint64 u = 1; u <= 3; u++) CHECK(writer.write(registerRecord(u, 10)));
+    for (uint32 i = 0; i < 200; i++) CHECK(writer.write(postRecord(1 + i % 3, 1 + (i + 1) % 3, 1 + i / 3, 20 + 10 * i)));
+    std::fflush(trace);
+
+    id first = replay(trace);
+    CHECK(first != id::zero() && first == replay(trace));
+
+    // A truncated record is reported, not silently dropped
+    long size = std::ftell(trace);
+    std::FILE* cut = std::tmpfile();
+    std::vector<uint8> bytes((size_t)size);
+    std::rewind(trace);
+    CHECK(std::fread(bytes.data(), 1, bytes.size(), trace) == bytes.size());
+    CHECK(std::fwrite(bytes.data(), 1, bytes.size() - 5, cut) == bytes.size() - 5);
+    std::rewind(cut);
+    qm::TraceReader reader(cut);
+    qm::TraceRecord record;
+    while (reader.next(record)) {}
+    CHECK(!reader.ok());
+
+    std::fclose(cut);
+    std::fclose(trace);
+    std::printf("trace replay ok\n");
+}
+
+int main() {
+    testRegistry();
+    testOwnerCollisions();
+    testNicknameCollisions();
+    testIndexShiftBudget();
+    testNonceWindow();
+    testDeviceLanes();
+    testRateTiers();
+    testInboxAcrossWrap();
+    testRangeReads();
+    testBatch();
+    testUnregisteredReceivers();
+    testDeliveryIndex();
+    testMerkleLog();
+    testMulticast();
+    testMulticastRingFull();
+    testBatchRoot();
+    testDispatcher();
+    testTraceReplay();
+    std::printf("all tests passed\n");
+    return 0;
+}
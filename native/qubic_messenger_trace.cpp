@@ -0,0 +1,101 @@
+#include "qubic_messenger_trace.h"
+
+#include <cstring>
+
+namespace qm {
+
+namespace {
+
+const char TRACE_MAGIC[8] = { 'Q', 'M', 'T', 'R', 'A', 'C', 'E', '\0' };
+const size_t RECORD_FIXED_SIZE = 4 + 2 + 2 + 32 + 4;
+
+void putLE(QPI::uint8* p, QPI::uint64 v, size_t n) {
+    for (size_t i = 0; i < n; i++) p[i] = (QPI::uint8)(v >> (8 * i));
+}
+
+QPI::uint64 getLE(const QPI::uint8* p, size_t n) {
+    QPI::uint64 v = 0;
+    for (size_t i = 0; i < n; i++) v |= (QPI::uint64)p[i] << (8 * i);
+    return v;
+}
+
+} // namespace
+
+TraceWriter::TraceWriter(std::FILE* file) : _file(file), _ok(file != nullptr) {
+    if (!_ok) return;
+    QPI::uint8 header[16] = {};
+    std::memcpy(header, TRACE_MAGIC, 8);
+    putLE(header + 8, TRACE_VERSION, 4);
+    _ok = std::fwrite(header, 1, sizeof(header), _file) == sizeof(header);
+}
+
+bool TraceWriter::write(const TraceRecord& record) {
+    if (!_ok) return false;
+    if (record.input.size() > TRACE_MAX_INPUT) return false;
+    QPI::uint8 fixed[RECORD_FIXED_SIZE];
+    putLE(fixed,     record.tick,      4);
+    putLE(fixed + 4, record.epoch,     2);
+    putLE(fixed + 6, record.procedure, 2);
+    std::memcpy(fixed + 8, record.invocator.m256i_u8, 32);
+    putLE(fixed + 40, record.input.size(), 4);
+    _ok = std::fwrite(fixed, 1, sizeof(fixed), _file) == sizeof(fixed) &&
+          std::fwrite(record.input.data(), 1, record.input.size(), _file) == record.input.size();
+    return _ok;
+}
+
+TraceReader::TraceReader(std::FILE* file) : _file(file), _ok(file != nullptr) {
+    if (!_ok) return;
+    QPI::uint8 header[16];
+    _ok = std::fread(header, 1, sizeof(header), _file) == sizeof(header) &&
+          std::memcmp(header, TRACE_MAGIC, 8) == 0 &&
+          getLE(header + 8, 4) == TRACE_VERSION;
+}
+
+bool TraceReader::next(TraceRecord& record) {
+    if (!_ok) return false;
+    QPI::uint8 fixed[RECORD_FIXED_SIZE];
+    size_t got = std::fread(fixed, 1, sizeof(fixed), _file);
+    if (got != sizeof(fixed)) {
+        _ok = got == 0 && std::feof(_file);  // a clean end of trace
+        return false;
+    }
+    record.tick      = (QPI::uint32)getLE(fixed, 4);
+    record.epoch     = (QPI::uint16)getLE(fixed + 4, 2);
+    record.procedure = (QPI::uint16)getLE(fixed + 6, 2);
+    std::memcpy(record.invocator.m256i_u8, fixed + 8, 32);
+    QPI::uint32 size = (QPI::uint32)getLE(fixed + 40, 4);
+    if (size > TRACE_MAX_INPUT) {
+        _ok = false;
+        return false;
+    }
+    record.input.resize(size);
+    if (std::fread(record.input.data(), 1, size, _file) != size) {
+        _ok = false;
+        return false;
+    }
+    return true;
+}
+
+void OutputDigest::add(QPI::uint16 procedure, const std::vector<QPI::uint8>& output) {
+    _buffer.resize(32 + 2 + 4 + output.size());
+    std::memcpy(_buffer.data(), _digest.m256i_u8, 32);
+    putLE(_buffer.data() + 32, procedure, 2);
+    putLE(_buffer.data() + 34, output.size(), 4);
+    if (!output.empty()) std::memcpy(_buffer.data() + 38, output.data(), output.size());
+    QPI::k12::hash(_buffer.data(), _buffer.size(), _digest.m256i_u8);
+}
+
+QPI::id stateDigest(const QubicMessenger& contract) {
+    QPI::id digest;
+    QPI::k12::hash(&contract, sizeof(QubicMessenger), digest.m256i_u8);
+    return digest;
+}
+
+bool applyRecord(const Dispatcher& dispatch, const TraceRecord& record, std::vector<QPI::uint8>& output) {
+    dispatch.context().setTick(record.tick);
+    dispatch.context().setEpoch(record.epoch);
+    dispatch.context().setInvocator(record.invocator);
+    return dispatch.invokeProcedure(record.procedure, record.input.data(), record.input.size(), output);
+}
+
+} // namespace qm
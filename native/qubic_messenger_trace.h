@@ -0,0 +1,85 @@
+#pragma once
+
+/**
+ * Transaction traces for the native QubicMessenger build
+ *
+ * A trace is a little-endian binary file:
+ *
+ *   header:  [8 magic "QMTRACE\0"][4 version][4 reserved]
+ *   record:  [4 tick][2 epoch][2 procedure][32 invocator][4 inputSize][inputSize input]
+ *
+ * procedure is a PROC index from qubic-client.ts and input is the raw
+ * transaction input, so a trace exported from the network replays unchanged.
+ */
+
+#include <cstdio>
+#include <vector>
+
+#include "qubic_messenger.h"
+
+namespace qm {
+
+constexpr QPI::uint32 TRACE_VERSION = 1;
+// Procedure inputs are at most 1024 bytes on chain; anything larger is a corrupt trace
+constexpr QPI::uint32 TRACE_MAX_INPUT = 1024;
+
+struct TraceRecord {
+    QPI::uint32 tick      = 0;
+    QPI::uint16 epoch     = 0;
+    QPI::uint16 procedure = 0;
+    QPI::id     invocator = QPI::id::zero();
+    std::vector<QPI::uint8> input;
+};
+
+class TraceWriter {
+public:
+    // Writes the header; check ok() before use
+    explicit TraceWriter(std::FILE* file);
+
+    bool ok() const { return _ok; }
+    bool write(const TraceRecord& record);
+
+private:
+    std::FILE* _file;
+    bool       _ok;
+};
+
+class TraceReader {
+public:
+    // Reads and checks the header; check ok() before use
+    explicit TraceReader(std::FILE* file);
+
+    bool ok() const { return _ok; }
+    // Returns false at the end of the trace, or on a truncated or corrupt
+    // record, after which ok() is false
+    bool next(TraceRecord& record);
+
+private:
+    std::FILE* _file;
+    bool       _ok;
+};
+
+// Running K12 over the outputs of a replay: after each record,
+// digest = K12(digest || procedure || output size || output). Outputs are the
+// contract's interface, so two layouts or indexes that process the same
+// trace the same way end with the same digest.
+class OutputDigest {
+public:
+    void add(QPI::uint16 procedure, const std::vector<QPI::uint8>& output);
+    const QPI::id& value() const { return _digest; }
+
+private:
+    QPI::id                 _digest = QPI::id::zero();
+    std::vector<QPI::uint8> _buffer;
+};
+
+// K12 over the raw contract state. Layout-specific: it only compares runs of
+// builds that share sizeof(QubicMessenger) and field order.
+QPI::id stateDigest(const QubicMessenger& contract);
+
+// Sets tick, epoch and invocator of the dispatcher's context from the record
+// and runs its procedure.
+// Returns false if the trace names an unknown procedure.
+bool applyRecord(const Dispatcher& dispatch, const TraceRecord& record, std::vector<QPI::uint8>& output);
+
+} // namespace qm
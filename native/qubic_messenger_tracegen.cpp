@@ -0,0 +1,329 @@
+/**
+ * Generates synthetic transaction traces for qubic_messenger_replay.
+ *
+ * Usage: qubic_messenger_tracegen OUT [--option=value ...]
+ *
+ *   --users=N            registered users at any time            (2000)
+ *   --messages=N         message events; a group burst is one     (200000)
+ *   --zipf=S             receiver popularity skew, 0 = uniform    (1.1)
+ *   --launch=F           share of users registered at launch      (0.8)
+ *   --group-share=F      share of events that are group bursts    (0.15)
+ *   --group-mean=N       mean group size (geometric, 2..30)       (8)
+ *   --group-mode=M       posts | batch | multicast | mixed        (mixed)
+ *   --churn=F            per event: a user deactivates and is
+ *                        replaced by a new registration           (0.001)
+ *   --reorder=F          per post: nonce submitted ahead of the
+ *                        previous one                             (0.05)
+ *   --tx-per-tick=N      records per tick                         (20)
+ *   --epoch-ticks=N      ticks per epoch                          (100000)
+ *   --seed=N                                                      (1)
+ *
+ * Receivers are drawn from a Zipf distribution over users in registration
+ * order, so the earliest accounts are the popular ones. Group bursts go out
+ * in one tick, as separate posts, a batch or a multicast. Nothing here
+ * models contract state: traffic that the contract rejects (rate limits,
+ * full tables) stays in the trace, as it would in production.
+ */
+
+#include "qubic_messenger_trace.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace QPI;
+
+// PROC indexes in qubic-client.ts
+static const uint16 PROC_REGISTER_USER       = 1;
+static const uint16 PROC_DEACTIVATE_USER     = 3;
+static const uint16 PROC_POST_MESSAGE_META   = 4;
+static const uint16 PROC_POST_MESSAGE_BATCH  = 5;
+static const uint16 PROC_POST_MULTICAST_META = 6;
+
+struct Options {
+    uint32      users       = 2000;
+    uint64      messages    = 200000;
+    double      zipf        = 1.1;
+    double      launch      = 0.8;
+    double      groupShare  = 0.15;
+    double      groupMean   = 8;
+    std::string groupMode   = "mixed";
+    double      churn       = 0.001;
+    double      reorder     = 0.05;
+    uint32      txPerTick   = 20;
+    uint32      epochTicks  = 100000;
+    uint64      seed        = 1;
+};
+
+static bool parseOption(Options& o, const char* arg) {
+    const char* eq = std::strchr(arg, '=');
+    if (std::strncmp(arg, "--", 2) != 0 || !eq) return false;
+    std::string name(arg + 2, eq);
+    const char* v = eq + 1;
+    if      (name == "users")       o.users      = (uint32)std::strtoul(v, nullptr, 10);
+    else if (name == "messages")    o.messages   = std::strtoull(v, nullptr, 10);
+    else if (name == "zipf")        o.zipf       = std::strtod(v, nullptr);
+    else if (name == "launch")      o.launch     = std::strtod(v, nullptr);
+    else if (name == "group-share") o.groupShare = std::strtod(v, nullptr);
+    else if (name == "group-mean")  o.groupMean  = std::strtod(v, nullptr);
+    else if (name == "group-mode")  o.groupMode  = v;
+    else if (name == "churn")       o.churn      = std::strtod(v, nullptr);
+    else if (name == "reorder")     o.reorder    = std::strtod(v, nullptr);
+    else if (name == "tx-per-tick") o.txPerTick  = (uint32)std::strtoul(v, nullptr, 10);
+    else if (name == "epoch-ticks") o.epochTicks = (uint32)std::strtoul(v, nullptr, 10);
+    else if (name == "seed")        o.seed       = std::strtoull(v, nullptr, 10);
+    else return false;
+    return true;
+}
+
+// One user slot in generator order; churn hands the slot to a new identity
+struct User {
+    uint64 identity = 0;   // 0 = not registered yet
+    uint32 nextNonce = 1;
+    uint32 heldNonce = 0;  // skipped by a reordered post, sent by the next one
+};
+
+class Generator {
+public:
+    Generator(const Options& o, qm::TraceWriter& writer)
+        : _o(o), _writer(writer), _rng(o.seed), _users(o.users) {
+        // Zipf CDF over ranks 1..users
+        _zipfCdf.resize(o.users);
+        double sum = 0;
+        for (uint32 r = 0; r < o.users; r++) {
+            sum += 1.0 / std::pow((double)(r + 1), o.zipf);
+            _zipfCdf[r] = sum;
+        }
+    }
+
+    void run() {
+        uint32 atLaunch = (uint32)(_o.users * _o.launch);
+        if (atLaunch < 2) atLaunch = _o.users < 2 ? _o.users : 2;
+        for (uint32 i = 0; i < atLaunch; i++) registerNext();
+
+        // The rest register at random points through the trace
+        std::vector<uint64> joins;
+        std::uniform_int_distribution<uint64> when(0, _o.messages ? _o.messages - 1 : 0);
+        for (uint32 i = atLaunch; i < _o.users; i++) joins.push_back(when(_rng));
+        std::sort(joins.begin(), joins.end());
+
+        size_t nextJoin = 0;
+        for (uint64 event = 0; event < _o.messages; event++) {
+            while (nextJoin < joins.size() && joins[nextJoin] <= event) {
+                registerNext();
+                nextJoin++;
+            }
+            if (chance(_o.churn)) churnOne();
+            if (chance(_o.groupShare)) groupBurst();
+            else directPost();
+        }
+    }
+
+    void summary() const {
+        std::fprintf(stderr, "records: %llu (register %llu, deactivate %llu, post %llu, batch %llu, multicast %llu)\n",
+                     (unsigned long long)_records, (unsigned long long)_count[PROC_REGISTER_USER],
+                     (unsigned long long)_count[PROC_DEACTIVATE_USER], (unsigned long long)_count[PROC_POST_MESSAGE_META],
+                     (unsigned long long)_count[PROC_POST_MESSAGE_BATCH], (unsigned long long)_count[PROC_POST_MULTICAST_META]);
+        std::fprintf(stderr, "ticks:   %u\n", _tick);
+    }
+
+private:
+    bool chance(double p) { return std::uniform_real_distribution<double>(0, 1)(_rng) < p; }
+
+    static id identityOf(uint64 n) {
+        id v = id::zero();
+        v.u64._0 = n * 0x9E3779B97F4A7C15ULL;
+        v.u64._1 = n;
+        return v;
+    }
+
+    template <typename Input>
+    void emit(uint16 procedure, uint64 identity, const Input& input) {
+        qm::TraceRecord r;
+        r.tick      = _tick;
+        r.epoch     = (uint16)(_o.epochTicks ? _tick / _o.epochTicks : 0);
+        r.procedure = procedure;
+        r.invocator = identityOf(identity);
+        r.input.assign((const uint8*)&input, (const uint8*)&input + sizeof(Input));
+        if (!_writer.write(r)) {
+            std::fprintf(stderr, "write failed\n");
+            std::exit(1);
+        }
+        _count[procedure]++;
+        _records++;
+        if (!_inBurst && ++_inTick == _o.txPerTick) nextTick();
+    }
+
+    void nextTick() {
+        _tick++;
+        _inTick = 0;
+    }
+
+    void registerUser(uint32 slot) {
+        User& u = _users[slot];
+        u = User();
+        u.identity = ++_identities;
+        QubicMessenger::RegisterUser_input in;
+        std::memset(&in, 0, sizeof(in));
+        std::snprintf((char*)in.nickname, QM_NICKNAME_LEN, "u%llu", (unsigned long long)u.identity);
+        std::memcpy(in.pubkey, &u.identity, sizeof(u.identity));
+        emit(PROC_REGISTER_USER, u.identity, in);
+    }
+
+    void registerNext() { registerUser(_registered++); }
+
+    void churnOne() {
+        if (_registered < 3) return;
+        uint32 slot = (uint32)(_rng() % _registered);
+        QubicMessenger::DeactivateUser_input in;
+        std::memset(&in, 0, sizeof(in));
+        emit(PROC_DEACTIVATE_USER, _users[slot].identity, in);
+        registerUser(slot);
+    }
+
+    // Zipf rank among the users registered so far
+    uint32 popularUser() {
+        double u = std::uniform_real_distribution<double>(0, _zipfCdf[_registered - 1])(_rng);
+        return (uint32)(std::lower_bound(_zipfCdf.begin(), _zipfCdf.begin() + _registered, u) - _zipfCdf.begin());
+    }
+
+    uint32 nonceFor(User& u) {
+        if (u.heldNonce) {
+            uint32 n = u.heldNonce;
+            u.heldNonce = 0;
+            return n;
+        }
+        if (chance(_o.reorder)) {
+            u.heldNonce = u.nextNonce;  // goes out after its successor
+            u.nextNonce++;
+        }
+        return u.nextNonce++;
+    }
+
+    static void hashOf(uint64 message, uint8 out[QM_HASH_LEN]) {
+        std::memset(out, 0, QM_HASH_LEN);
+        std::memcpy(out, &message, sizeof(message));
+        out[QM_HASH_LEN - 1] = 0x5A;
+    }
+
+    void post(uint32 from, uint32 to) {
+        QubicMessenger::PostMessageMeta_input in;
+        std::memset(&in, 0, sizeof(in));
+        in.receiver = identityOf(_users[to].identity);
+        hashOf(++_messageIds, in.contentHash);
+        in.nonce = nonceFor(_users[from]);
+        emit(PROC_POST_MESSAGE_META, _users[from].identity, in);
+    }
+
+    void directPost() {
+        if (_registered < 2) return;
+        uint32 from = (uint32)(_rng() % _registered);
+        uint32 to = popularUser();
+        while (to == from) to = popularUser();
+        post(from, to);
+    }
+
+    void groupBurst() {
+        if (_registered < 3) return;
+        // Geometric size with the requested mean, clamped to 2..30 members
+        double p = 1.0 / std::max(1.0, _o.groupMean - 1);
+        uint32 size = 2 + std::geometric_distribution<uint32>(p)(_rng);
+        size = std::min<uint32>({ size, QM_MCAST_MAX_RECEIVERS + 1, _registered });
+
+        std::vector<uint32> members;
+        while (members.size() < size) {
+            uint32 m = popularUser();
+            if (std::find(members.begin(), members.end(), m) == members.end()) members.push_back(m);
+        }
+        uint32 from = members[_rng() % members.size()];
+        members.erase(std::find(members.begin(), members.end(), from));
+
+        std::string mode = _o.groupMode;
+        if (mode == "mixed") {
+            static const char* modes[] = { "posts", "batch", "multicast" };
+            mode = modes[_rng() % 3];
+        }
+
+        // Every burst goes out within a tick of its own
+        if (_inTick) nextTick();
+        _inBurst = true;
+        if (mode == "multicast") {
+            QubicMessenger::PostMulticastMeta_input in;
+            std::memset(&in, 0, sizeof(in));
+            for (size_t i = 0; i < members.size(); i++) in.receivers[i] = identityOf(_users[members[i]].identity);
+            in.count = (uint8)members.size();
+            hashOf(++_messageIds, in.contentHash);
+            in.nonce = nonceFor(_users[from]);
+            emit(PROC_POST_MULTICAST_META, _users[from].identity, in);
+        } else if (mode == "batch") {
+            for (size_t at = 0; at < members.size(); at += QM_BATCH_MAX) {
+                QubicMessenger::PostMessageMetaBatch_input in;
+                std::memset(&in, 0, sizeof(in));
+                size_t n = std::min<size_t>(QM_BATCH_MAX, members.size() - at);
+                uint64 message = ++_messageIds;
+                for (size_t i = 0; i < n; i++) {
+                    in.receivers[i] = identityOf(_users[members[at + i]].identity);
+                    hashOf(message, in.contentHashes[i]);
+                    in.contentHashes[i][QM_HASH_LEN - 2] = (uint8)(at + i);  // one ciphertext per member
+                    in.nonces[i] = nonceFor(_users[from]);
+                }
+                in.count = (uint8)n;
+                emit(PROC_POST_MESSAGE_BATCH, _users[from].identity, in);
+            }
+        } else {
+            for (uint32 m : members) post(from, m);
+        }
+        _inBurst = false;
+        nextTick();
+    }
+
+    const Options&     _o;
+    qm::TraceWriter&   _writer;
+    std::mt19937_64    _rng;
+    std::vector<User>  _users;
+    std::vector<double> _zipfCdf;
+    uint32 _registered = 0;
+    uint64 _identities = 0;
+    uint64 _messageIds = 0;
+    uint64 _records    = 0;
+    uint32 _tick       = 1;
+    uint32 _inTick     = 0;      // records emitted in the current tick
+    bool   _inBurst    = false;  // a group burst keeps the tick until it is done
+    uint64 _count[PROC_POST_MULTICAST_META + 1] = {};
+};
+
+int main(int argc, char** argv) {
+    Options o;
+    if (argc < 2 || argv[1][0] == '-') {
+        std::fprintf(stderr, "usage: %s OUT [--option=value ...]  (options are listed in the source header)\n", argv[0]);
+        return 2;
+    }
+    for (int i = 2; i < argc; i++) {
+        if (!parseOption(o, argv[i])) {
+            std::fprintf(stderr, "unknown option %s\n", argv[i]);
+            return 2;
+        }
+    }
+    if (o.users < 2 || o.users > QM_MAX_USERS || o.txPerTick == 0 ||
+        (o.groupMode != "posts" && o.groupMode != "batch" && o.groupMode != "multicast" && o.groupMode != "mixed")) {
+        std::fprintf(stderr, "invalid options: users must be 2..%d, tx-per-tick > 0, group-mode one of posts|batch|multicast|mixed\n",
+                     QM_MAX_USERS);
+        return 2;
+    }
+
+    std::FILE* file = std::fopen(argv[1], "wb");
+    qm::TraceWriter writer(file);
+    if (!writer.ok()) {
+        std::fprintf(stderr, "cannot write %s\n", argv[1]);
+        return 1;
+    }
+    Generator generator(o, writer);
+    generator.run();
+    generator.summary();
+    return std::fclose(file) == 0 ? 0 : 1;
+}
@@ -20,6 +20,10 @@ export const PROC = {
   UPDATE_PUBKEY:     2,
   DEACTIVATE_USER:   3,
   POST_MESSAGE_META: 4,
+  POST_MESSAGE_META_BATCH: 5,
+  POST_MULTICAST_META:     6,
+  POST_BATCH_ROOT:         7,
+  ADD_DEVICE_LANE:         8,
 } as const;
 
 // Function indexes (read-only)
@@ -27,6 +31,18 @@ export const FUNC = {
   LOOKUP_USER:          0,
   LOOKUP_USER_BY_OWNER: 1,
   GET_MESSAGE_META:     2,
+  GET_MESSAGE_META_BY_SEQ: 3,
+  GET_MESSAGE_META_RANGE:  4,
+  GET_INBOX:               5,
+  GET_INBOX_HEAD:          6,
+  GET_OUTBOX:              7,
+  GET_MESSAGES_BY_TICK_RANGE: 8,
+  VERIFY_DELIVERY:         9,
+  GET_LOG_ROOT:            10,
+  GET_INCLUSION_PROOF:     11,
+  GET_SEGMENT_ROOT:        12,
+  GET_MULTICAST_RECEIVERS: 13,
+  VERIFY_BATCH_LEAF:       14,
 } as const;
 
 // ─── Encoding Helpers ─────────────────────────────────────────────────────────
@@ -36,6 +52,37 @@ const PUBKEY_LEN   = 32;
 const HASH_LEN     = 32;
 const ID_LEN       = 32;
 
+// sizeof(QM_MessageMeta): 112 bytes of fields padded to id's 32-byte alignment
+const MESSAGE_META_SIZE = 128;
+// QM_RANGE_MAX in QubicMessenger.h
+export const RANGE_MAX  = 64;
+// QM_NONCE_WINDOW in QubicMessenger.h: nonces may arrive out of order as long
+// as they are unused and no more than this far below the highest one accepted
+// on the same lane
+export const NONCE_WINDOW = 64;
+// QM_MAX_LANES in QubicMessenger.h: each device posts on its own lane, with
+// its own nonces; lane 0 exists from registration
+export const MAX_LANES = 4;
+// QM_RATE_CAPACITY_* / QM_RATE_REFILL_TICKS_* in QubicMessenger.h, keyed like
+// TIERS in token-gate.ts. The contract re-reads a user's tier from their
+// balance on the first post of each epoch.
+export const RATE_LIMITS = {
+  FREE:    { capacity: 5,  refillTicks: 10 },
+  SILVER:  { capacity: 10, refillTicks: 5 },
+  GOLD:    { capacity: 20, refillTicks: 2 },
+  DIAMOND: { capacity: 40, refillTicks: 1 },
+} as const;
+// QM_BATCH_MAX in QubicMessenger.h
+export const BATCH_MAX  = 15;
+// QM_MCAST_MAX_RECEIVERS in QubicMessenger.h
+export const MCAST_MAX_RECEIVERS = 30;
+// QM_BATCH_TREE_DEPTH in QubicMessenger.h
+export const BATCH_TREE_DEPTH = 24;
+// QM_MMR_MAX_HEIGHT in QubicMessenger.h
+const MMR_MAX_HEIGHT = 64;
+// QM_SEGMENT_SIZE in QubicMessenger.h: seq s belongs to segment (s - 1) / SEGMENT_SIZE
+export const SEGMENT_SIZE = 1024n;
+
 export function encodeNickname(name: string): Uint8Array {
   const buf = new Uint8Array(NICKNAME_LEN);
   const enc = new TextEncoder().encode(name).slice(0, NICKNAME_LEN);
@@ -59,19 +106,129 @@ export interface UserInfo {
   found: boolean;
 }
 
+// QM_KIND_* in QubicMessenger.h
+export const KIND = {
+  DIRECT:     0,
+  MULTICAST:  1,
+  BATCH_ROOT: 2,
+} as const;
+
 export interface MessageMetaEntry {
   sender: string;
-  receiver: string;
+  receiver: string;   // empty id for multicast entries outside inbox pages
   contentHash: Uint8Array;
   tick: number;
   nonce: number;
   valid: boolean;
+  kind?: number;      // KIND.*
+  leafCount?: number; // batch roots only
+  seq?: bigint;   // global sequence number held by the entry
+}
+
+export interface MessageMetaRange {
+  entries: MessageMetaEntry[];
+  nextSeq: bigint;   // pass as startSeq to continue
+  evicted: bigint;   // seqs from startSeq that were already overwritten
+}
+
+export interface InboxPage {
+  entries: MessageMetaEntry[];  // newest first
+  nextBeforeSeq: bigint;        // 0n when the page reached sinceSeq
+  truncated: boolean;           // older entries were evicted from the ring
+}
+
+export interface InboxHead {
+  latestSeq: bigint;   // newest inbound seq, 0n = none
+  totalCount: number;
+  lastTick: number;
+  found: boolean;
+}
+
+export interface TickRangePage {
+  entries: MessageMetaEntry[];  // oldest first
+  nextSeq: bigint;              // non-zero if more entries remain: pass as startSeq
+  evicted: boolean;             // the start of the range may have left the ring
+}
+
+export interface DeliveryProof {
+  sender: string;
+  receiver: string;
+  seq: bigint;
+  tick: number;
+  nonce: number;
+  found: boolean;
+  kind: number;
+  truncated: boolean;  // the walk gave up before reaching the last entry with the hash
+}
+
+export interface BatchLeafCheck {
+  sender: string;     // who posted the root
+  tick: number;
+  leafCount: number;
+  valid: boolean;
+  errorCode: number;  // 0=ok, 1=rootSeq evicted or not a batch root, 2=leafIndex out of range,
+                      // 3=path mismatch
+}
+
+export interface MulticastResult {
+  success: boolean;
+  errorCode: number;   // 0=ok, 1=not registered, 2=bad nonce, 3=rate limited,
+                       // 6=bad count, 7=no registered receivers, 9=unknown lane
+  seq: bigint;         // with fanout, the first of `linked` consecutive seqs
+  linked: number;      // receivers whose inbox got the entry
+  skippedMask: number; // bit i: receivers[i] unregistered, yourself, or a duplicate
+  fanout: boolean;     // receiver ring was full: one direct entry per receiver
+}
+
+export interface LogRoot {
+  root: Uint8Array;   // all zero while the log is empty
+  leafCount: bigint;
+}
+
+export interface InclusionProof {
+  siblings: Uint8Array[];  // leaf upwards
+  peaks: Uint8Array[];     // left to right, tallest first
+  peakIndex: number;       // peak the sibling path ends at
+  root: Uint8Array;
+  leafCount: bigint;
+  available: boolean;
+}
+
+export interface SegmentRoot {
+  root: Uint8Array;
+  firstSeq: bigint;
+  closedCount: bigint;
+  firstTick: number;
+  lastTick: number;
+  epoch: number;
+  found: boolean;
+}
+
+export interface BatchEntry {
+  receiverAddress: string;
+  contentHash: Uint8Array;
+  nonce: number;   // unused, and within NONCE_WINDOW of the lane's highest nonce
+}
+
+export interface PostBatchResult {
+  errorCode: number;       // whole batch: 0=ok, 1=not registered, 3=rate limited, 6=bad count,
+                           // 9=unknown lane
+  accepted: number;
+  entryErrors: number[];   // per entry: 0=ok, 2=bad nonce, 4=self-message, 5=receiver table full
+  seqs: bigint[];          // 0n where the entry was rejected
+}
+
+export interface DeviceLaneResult {
+  lane: number;
+  success: boolean;
+  errorCode: number;   // 0=ok, 1=not registered, 9=all MAX_LANES lanes in use
 }
 
 export interface PostMetaResult {
   success: boolean;
   errorCode: number;
   logIndex: number;
+  seq: bigint;    // stable handle for getMessageMetaBySeq
 }
 
 // ─── Client ───────────────────────────────────────────────────────────────────
@@ -86,7 +243,9 @@ export class QubicMessengerClient {
    * Register a nickname + X25519 pubkey on-chain.
    * The caller's Qubic wallet identity becomes the owner.
    *
-   * @returns slot index (>= 0) or negative error code
+   * @returns slot index (>= 0) or negative error code: -1 nickname taken,
+   *          -2 registry full, -3 already registered, -4 index probe window
+   *          full (try another nickname)
    */
   async registerUser(
     seed: string,
@@ -171,18 +330,21 @@ export class QubicMessengerClient {
   /**
    * Post message metadata on-chain for delivery proof / receipt.
    * The content hash is BLAKE2b-256 of the encrypted ciphertext.
+   * The nonce is checked against this device's lane (see addDeviceLane).
    */
   async postMessageMeta(
     seed: string,
     receiverAddress: string,
     contentHash: Uint8Array,
-    nonce: number
+    nonce: number,
+    lane: number = 0
   ): Promise<PostMetaResult> {
-    // Input: [32 receiver id][32 contentHash][4 nonce]
-    const input = new Uint8Array(68);
+    // Input: [32 receiver id][32 contentHash][4 nonce][1 lane]
+    const input = new Uint8Array(69);
     input.set(this.helper.getBytesFromIdentity(receiverAddress), 0);
     input.set(contentHash, ID_LEN);
     new DataView(input.buffer).setUint32(ID_LEN + HASH_LEN, nonce, true);
+    input[ID_LEN + HASH_LEN + 4] = lane;
 
     const tx = await this.helper.createTransaction(
       seed,
@@ -193,17 +355,225 @@ export class QubicMessengerClient {
     );
     const result = await this.helper.broadcastTransaction(tx) as Uint8Array;
 
-    // Output: [1 success][1 errorCode][4 logIndex]
+    // Output: [1 success][1 errorCode][2 pad][4 logIndex][8 seq]
     const view = new DataView(result.buffer);
     return {
       success:   result[0] === 1,
       errorCode: result[1],
-      logIndex:  view.getUint32(2, true),
+      logIndex:  view.getUint32(4, true),
+      seq:       view.getBigUint64(8, true),
+    };
+  }
+
+  /**
+   * Post up to BATCH_MAX receipts in one transaction (e.g. a group message
+   * fanned out to every member). Spends a single rate-limit token.
+   */
+  async postMessageMetaBatch(
+    seed: string,
+    entries: BatchEntry[],
+    lane: number = 0
+  ): Promise<PostBatchResult> {
+    if (entries.length === 0 || entries.length > BATCH_MAX) {
+      throw new Error(`Batch must hold 1..${BATCH_MAX} entries`);
+    }
+
+    // Input: [15 x 32 receivers][15 x 32 contentHashes][15 x 4 nonces][1 count][1 lane][2 pad]
+    const input = new Uint8Array(1024);
+    const view  = new DataView(input.buffer);
+    const hashesAt = BATCH_MAX * ID_LEN;
+    const noncesAt = hashesAt + BATCH_MAX * HASH_LEN;
+    entries.forEach((e, i) => {
+      input.set(this.helper.getBytesFromIdentity(e.receiverAddress), i * ID_LEN);
+      input.set(e.contentHash, hashesAt + i * HASH_LEN);
+      view.setUint32(noncesAt + i * 4, e.nonce, true);
+    });
+    input[noncesAt + BATCH_MAX * 4] = entries.length;
+    input[noncesAt + BATCH_MAX * 4 + 1] = lane;
+
+    const tx = await this.helper.createTransaction(
+      seed,
+      this.contractIndex,
+      PROC.POST_MESSAGE_META_BATCH,
+      0,
+      input
+    );
+    const result = await this.helper.broadcastTransaction(tx) as Uint8Array;
+
+    // Output: [15 x 8 seqs][15 entryErrors][1 accepted][1 errorCode]
+    const out = new DataView(result.buffer, result.byteOffset);
+    const errorsAt = BATCH_MAX * 8;
+    const seqs: bigint[] = [];
+    const entryErrors: number[] = [];
+    for (let i = 0; i < entries.length; i++) {
+      seqs.push(out.getBigUint64(i * 8, true));
+      entryErrors.push(result[errorsAt + i]);
+    }
+    return {
+      errorCode: result[errorsAt + BATCH_MAX + 1],
+      accepted:  result[errorsAt + BATCH_MAX],
+      entryErrors,
+      seqs,
+    };
+  }
+
+  /**
+   * Post one receipt for a ciphertext shared by up to MCAST_MAX_RECEIVERS
+   * registered users (e.g. a group message). It takes one log entry and
+   * shows up in every receiver's inbox.
+   */
+  async postMulticastMeta(
+    seed: string,
+    receiverAddresses: string[],
+    contentHash: Uint8Array,
+    nonce: number,
+    lane: number = 0
+  ): Promise<MulticastResult> {
+    if (receiverAddresses.length === 0 || receiverAddresses.length > MCAST_MAX_RECEIVERS) {
+      throw new Error(`Multicast must name 1..${MCAST_MAX_RECEIVERS} receivers`);
+    }
+
+    // Input: [30 x 32 receivers][32 contentHash][4 nonce][1 count][1 lane][26 pad]
+    const input = new Uint8Array(1024);
+    const hashAt = MCAST_MAX_RECEIVERS * ID_LEN;
+    receiverAddresses.forEach((addr, i) => {
+      input.set(this.helper.getBytesFromIdentity(addr), i * ID_LEN);
+    });
+    input.set(contentHash, hashAt);
+    new DataView(input.buffer).setUint32(hashAt + HASH_LEN, nonce, true);
+    input[hashAt + HASH_LEN + 4] = receiverAddresses.length;
+    input[hashAt + HASH_LEN + 5] = lane;
+
+    const tx = await this.helper.createTransaction(
+      seed,
+      this.contractIndex,
+      PROC.POST_MULTICAST_META,
+      0,
+      input
+    );
+    const result = await this.helper.broadcastTransaction(tx) as Uint8Array;
+
+    // Output: [8 seq][4 skippedMask][1 linked][1 success][1 errorCode][1 fanout]
+    const view = new DataView(result.buffer, result.byteOffset);
+    return {
+      seq:         view.getBigUint64(0, true),
+      skippedMask: view.getUint32(8, true),
+      linked:      result[12],
+      success:     result[13] === 1,
+      errorCode:   result[14],
+      fanout:      result[15] === 1,
+    };
+  }
+
+  /**
+   * Receivers of a live multicast entry, in the order hashed into its MMR leaf.
+   */
+  async getMulticastReceivers(seq: bigint): Promise<{ receivers: string[]; found: boolean }> {
+    const input = new Uint8Array(8);
+    new DataView(input.buffer).setBigUint64(0, seq, true);
+
+    const raw = await this.helper.queryContractFunction(
+      this.contractIndex,
+      FUNC.GET_MULTICAST_RECEIVERS,
+      input
+    ) as Uint8Array;
+
+    // Output: [30 x 32 receivers][4 count][1 found]
+    const tail  = MCAST_MAX_RECEIVERS * ID_LEN;
+    const count = new DataView(raw.buffer, raw.byteOffset).getUint32(tail, true);
+    const receivers: string[] = [];
+    for (let i = 0; i < count; i++) {
+      receivers.push(this.helper.getIdentityFromBytes(raw.slice(i * ID_LEN, (i + 1) * ID_LEN)));
+    }
+    return { receivers, found: raw[tail + 4] === 1 };
+  }
+
+  /**
+   * Record one receipt for a whole batch of messages: the Merkle root over
+   * their (receiver, contentHash, nonce) leaves. Hand each receiver its path
+   * so it can call verifyBatchLeaf.
+   */
+  async postBatchRoot(
+    seed: string,
+    root: Uint8Array,
+    leafCount: number,
+    nonce: number,
+    lane: number = 0
+  ): Promise<PostMetaResult> {
+    // Input: [32 root][4 leafCount][4 nonce][1 lane][3 pad]
+    const input = new Uint8Array(44);
+    input.set(root, 0);
+    const view = new DataView(input.buffer);
+    view.setUint32(HASH_LEN, leafCount, true);
+    view.setUint32(HASH_LEN + 4, nonce, true);
+    input[HASH_LEN + 8] = lane;
+
+    const tx = await this.helper.createTransaction(
+      seed,
+      this.contractIndex,
+      PROC.POST_BATCH_ROOT,
+      0,
+      input
+    );
+    const result = await this.helper.broadcastTransaction(tx) as Uint8Array;
+
+    // Output: [1 success][1 errorCode][2 pad][4 logIndex][8 seq]
+    const out = new DataView(result.buffer, result.byteOffset);
+    return {
+      success:   result[0] === 1,
+      errorCode: result[1],
+      logIndex:  out.getUint32(4, true),
+      seq:       out.getBigUint64(8, true),
+    };
+  }
+
+  /**
+   * Check one batch leaf against the root posted at `rootSeq`. `path` holds
+   * the sibling hashes from the leaf upwards, ceil(log2(leafCount)) of them.
+   */
+  async verifyBatchLeaf(
+    rootSeq: bigint,
+    leafIndex: number,
+    receiverAddress: string,
+    contentHash: Uint8Array,
+    nonce: number,
+    path: Uint8Array[]
+  ): Promise<BatchLeafCheck> {
+    if (path.length > BATCH_TREE_DEPTH) {
+      throw new Error(`Batch path is limited to ${BATCH_TREE_DEPTH} levels`);
+    }
+
+    // Input: [24 x 32 path][32 receiver][32 contentHash][8 rootSeq][4 leafIndex][4 nonce][16 pad]
+    const input = new Uint8Array(864);
+    path.forEach((node, i) => input.set(node, i * ID_LEN));
+    const tail = BATCH_TREE_DEPTH * ID_LEN;
+    input.set(this.helper.getBytesFromIdentity(receiverAddress), tail);
+    input.set(contentHash, tail + ID_LEN);
+    const view = new DataView(input.buffer);
+    view.setBigUint64(tail + ID_LEN + HASH_LEN, rootSeq, true);
+    view.setUint32(tail + ID_LEN + HASH_LEN + 8, leafIndex, true);
+    view.setUint32(tail + ID_LEN + HASH_LEN + 12, nonce, true);
+
+    const raw = await this.helper.queryContractFunction(
+      this.contractIndex,
+      FUNC.VERIFY_BATCH_LEAF,
+      input
+    ) as Uint8Array;
+
+    // Output: [32 sender][4 tick][4 leafCount][1 valid][1 errorCode]
+    const out = new DataView(raw.buffer, raw.byteOffset);
+    return {
+      sender:    this.helper.getIdentityFromBytes(raw.slice(0, ID_LEN)),
+      tick:      out.getUint32(ID_LEN, true),
+      leafCount: out.getUint32(ID_LEN + 4, true),
+      valid:     raw[ID_LEN + 8] === 1,
+      errorCode: raw[ID_LEN + 9],
     };
   }
 
   /**
    * Fetch a message metadata entry by ring buffer index.
+   * Prefer getMessageMetaBySeq: a ring index is reused once the log wraps.
    */
   async getMessageMeta(logIndex: number): Promise<MessageMetaEntry> {
     const input = new Uint8Array(4);
@@ -215,7 +585,7 @@ export class QubicMessengerClient {
       input
     ) as Uint8Array;
 
-    // Output: [32 sender][32 receiver][32 contentHash][4 tick][4 nonce][1 valid]
+    // Output: [32 sender][32 receiver][32 contentHash][4 tick][4 nonce][1 valid][7 pad][8 seq][1 kind]
     const view = new DataView(raw.buffer);
     let offset = 0;
     const sender   = this.helper.getIdentityFromBytes(raw.slice(offset, offset + ID_LEN)); offset += ID_LEN;
@@ -224,8 +594,344 @@ export class QubicMessengerClient {
     const tick  = view.getUint32(offset, true); offset += 4;
     const nonce = view.getUint32(offset, true); offset += 4;
     const valid = raw[offset] === 1;
+    const seq   = view.getBigUint64(offset + 8, true);
+    const kind  = raw[offset + 16];
 
-    return { sender, receiver, contentHash, tick, nonce, valid };
+    return { sender, receiver, contentHash, tick, nonce, valid, seq, kind };
+  }
+
+  /**
+   * Fetch a message metadata entry by global sequence number.
+   * `valid` is false if the seq was never posted or has been evicted from the ring.
+   */
+  async getMessageMetaBySeq(seq: bigint): Promise<MessageMetaEntry> {
+    const input = new Uint8Array(8);
+    new DataView(input.buffer).setBigUint64(0, seq, true);
+
+    const raw = await this.helper.queryContractFunction(
+      this.contractIndex,
+      FUNC.GET_MESSAGE_META_BY_SEQ,
+      input
+    ) as Uint8Array;
+
+    // Output: [32 sender][32 receiver][32 contentHash][4 tick][4 nonce][1 valid][1 kind][2 pad][4 leafCount]
+    const view = new DataView(raw.buffer);
+    let offset = 0;
+    const sender   = this.helper.getIdentityFromBytes(raw.slice(offset, offset + ID_LEN)); offset += ID_LEN;
+    const receiver = this.helper.getIdentityFromBytes(raw.slice(offset, offset + ID_LEN)); offset += ID_LEN;
+    const contentHash = raw.slice(offset, offset + HASH_LEN); offset += HASH_LEN;
+    const tick  = view.getUint32(offset, true); offset += 4;
+    const nonce = view.getUint32(offset, true); offset += 4;
+    const valid = raw[offset] === 1;
+    const kind  = raw[offset + 1];
+    const leafCount = view.getUint32(offset + 4, true);
+
+    return { sender, receiver, contentHash, tick, nonce, valid, seq, kind, leafCount };
+  }
+
+  /**
+   * Fetch up to RANGE_MAX consecutive entries starting at startSeq in one query.
+   * Keep calling with the returned nextSeq until it stops advancing.
+   */
+  async getMessageMetaRange(startSeq: bigint, count: number = RANGE_MAX): Promise<MessageMetaRange> {
+    const input = new Uint8Array(12);
+    const inView = new DataView(input.buffer);
+    inView.setBigUint64(0, startSeq, true);
+    inView.setUint32(8, count, true);
+
+    const raw = await this.helper.queryContractFunction(
+      this.contractIndex,
+      FUNC.GET_MESSAGE_META_RANGE,
+      input
+    ) as Uint8Array;
+
+    // Output: [RANGE_MAX x QM_MessageMeta][8 nextSeq][8 evicted][4 count]
+    const view  = new DataView(raw.buffer);
+    const tail  = RANGE_MAX * MESSAGE_META_SIZE;
+    const filled = view.getUint32(tail + 16, true);
+    const entries: MessageMetaEntry[] = [];
+    for (let i = 0; i < filled; i++) {
+      entries.push(this.decodeMessageMeta(raw, i * MESSAGE_META_SIZE));
+    }
+    return {
+      entries,
+      nextSeq: view.getBigUint64(tail, true),
+      evicted: view.getBigUint64(tail + 8, true),
+    };
+  }
+
+  /**
+   * Fetch entries addressed to `receiverAddress` with seq > sinceSeq, newest first.
+   * Only walks that receiver's own chain, so cost scales with their traffic.
+   * Pass the returned nextBeforeSeq as beforeSeq to page further back.
+   */
+  async getInbox(
+    receiverAddress: string,
+    sinceSeq: bigint = 0n,
+    beforeSeq: bigint = 0n,
+    maxCount: number = RANGE_MAX
+  ): Promise<InboxPage> {
+    // Input: [32 receiver id][8 sinceSeq][8 beforeSeq][4 maxCount]
+    const input = new Uint8Array(ID_LEN + 20);
+    const inView = new DataView(input.buffer);
+    input.set(this.helper.getBytesFromIdentity(receiverAddress), 0);
+    inView.setBigUint64(ID_LEN, sinceSeq, true);
+    inView.setBigUint64(ID_LEN + 8, beforeSeq, true);
+    inView.setUint32(ID_LEN + 16, maxCount, true);
+
+    const raw = await this.helper.queryContractFunction(
+      this.contractIndex,
+      FUNC.GET_INBOX,
+      input
+    ) as Uint8Array;
+
+    return this.decodeMessagePage(raw);
+  }
+
+  /**
+   * Fetch entries posted by `senderAddress` with seq > sinceSeq, newest first.
+   * Lets another device rebuild "sent" history without scanning the log.
+   */
+  async getOutbox(
+    senderAddress: string,
+    sinceSeq: bigint = 0n,
+    beforeSeq: bigint = 0n,
+    maxCount: number = RANGE_MAX
+  ): Promise<InboxPage> {
+    // Input: [32 sender id][8 sinceSeq][8 beforeSeq][4 maxCount]
+    const input = new Uint8Array(ID_LEN + 20);
+    const inView = new DataView(input.buffer);
+    input.set(this.helper.getBytesFromIdentity(senderAddress), 0);
+    inView.setBigUint64(ID_LEN, sinceSeq, true);
+    inView.setBigUint64(ID_LEN + 8, beforeSeq, true);
+    inView.setUint32(ID_LEN + 16, maxCount, true);
+
+    const raw = await this.helper.queryContractFunction(
+      this.contractIndex,
+      FUNC.GET_OUTBOX,
+      input
+    ) as Uint8Array;
+
+    return this.decodeMessagePage(raw);
+  }
+
+  /**
+   * Fetch entries posted between fromTick and toTick (inclusive), oldest first.
+   * Pass the returned nextSeq back as startSeq to read the next page.
+   */
+  async getMessagesByTickRange(
+    fromTick: number,
+    toTick: number,
+    startSeq: bigint = 0n
+  ): Promise<TickRangePage> {
+    // Input: [4 fromTick][4 toTick][8 startSeq]
+    const input = new Uint8Array(16);
+    const inView = new DataView(input.buffer);
+    inView.setUint32(0, fromTick, true);
+    inView.setUint32(4, toTick, true);
+    inView.setBigUint64(8, startSeq, true);
+
+    const raw = await this.helper.queryContractFunction(
+      this.contractIndex,
+      FUNC.GET_MESSAGES_BY_TICK_RANGE,
+      input
+    ) as Uint8Array;
+
+    // Output: [RANGE_MAX x QM_MessageMeta][8 nextSeq][4 count][1 evicted]
+    const view = new DataView(raw.buffer, raw.byteOffset);
+    const tail = RANGE_MAX * MESSAGE_META_SIZE;
+    const filled = view.getUint32(tail + 8, true);
+    const entries: MessageMetaEntry[] = [];
+    for (let i = 0; i < filled; i++) {
+      entries.push(this.decodeMessageMeta(raw, i * MESSAGE_META_SIZE));
+    }
+    return {
+      entries,
+      nextSeq: view.getBigUint64(tail, true),
+      evicted: raw[tail + 12] === 1,
+    };
+  }
+
+  /**
+   * Look up the oldest live entry carrying `contentHash` (delivery proof),
+   * optionally only one sent by `senderAddress` to `receiverAddress`.
+   * Multicast fan-outs and batches share a hash across receivers, so pass the
+   * receiver to prove delivery to a particular one. Later re-posts of the
+   * same hash by anyone cannot replace an earlier entry.
+   */
+  async verifyDelivery(
+    contentHash: Uint8Array,
+    senderAddress?: string,
+    receiverAddress?: string
+  ): Promise<DeliveryProof> {
+    // Input: [32 contentHash][32 sender id][32 receiver id], zero id = any
+    const input = new Uint8Array(HASH_LEN + 2 * ID_LEN);
+    input.set(contentHash, 0);
+    if (senderAddress) input.set(this.helper.getBytesFromIdentity(senderAddress), HASH_LEN);
+    if (receiverAddress) input.set(this.helper.getBytesFromIdentity(receiverAddress), HASH_LEN + ID_LEN);
+
+    const raw = await this.helper.queryContractFunction(
+      this.contractIndex,
+      FUNC.VERIFY_DELIVERY,
+      input
+    ) as Uint8Array;
+
+    // Output: [32 sender][32 receiver][8 seq][4 tick][4 nonce][1 found][1 kind][1 truncated]
+    const view = new DataView(raw.buffer, raw.byteOffset);
+    return {
+      sender:    this.helper.getIdentityFromBytes(raw.slice(0, ID_LEN)),
+      receiver:  this.helper.getIdentityFromBytes(raw.slice(ID_LEN, 2 * ID_LEN)),
+      seq:       view.getBigUint64(2 * ID_LEN, true),
+      tick:      view.getUint32(2 * ID_LEN + 8, true),
+      nonce:     view.getUint32(2 * ID_LEN + 12, true),
+      found:     raw[2 * ID_LEN + 16] === 1,
+      kind:      raw[2 * ID_LEN + 17],
+      truncated: raw[2 * ID_LEN + 18] === 1,
+    };
+  }
+
+  /**
+   * Current Merkle Mountain Range root over every entry ever posted.
+   */
+  async getLogRoot(): Promise<LogRoot> {
+    const raw = await this.helper.queryContractFunction(
+      this.contractIndex,
+      FUNC.GET_LOG_ROOT,
+      new Uint8Array(0)
+    ) as Uint8Array;
+
+    // Output: [32 root][8 leafCount]
+    const view = new DataView(raw.buffer, raw.byteOffset);
+    return {
+      root:      raw.slice(0, ID_LEN),
+      leafCount: view.getBigUint64(ID_LEN, true),
+    };
+  }
+
+  /**
+   * Inclusion proof for `seq` against the current log root. Check it with
+   * K12 over the entry's QM_MmrLeaf preimage (see QubicMessenger.h) rather
+   * than trusting getMessageMetaBySeq.
+   */
+  async getInclusionProof(seq: bigint): Promise<InclusionProof> {
+    const input = new Uint8Array(8);
+    new DataView(input.buffer).setBigUint64(0, seq, true);
+
+    const raw = await this.helper.queryContractFunction(
+      this.contractIndex,
+      FUNC.GET_INCLUSION_PROOF,
+      input
+    ) as Uint8Array;
+
+    // Output: [64 x 32 siblings][64 x 32 peaks][32 root][8 leafCount]
+    //         [4 siblingCount][4 peakCount][4 peakIndex][1 available]
+    const view = new DataView(raw.buffer, raw.byteOffset);
+    const peaksAt = MMR_MAX_HEIGHT * ID_LEN;
+    const tail = 2 * peaksAt;
+    const siblingCount = view.getUint32(tail + ID_LEN + 8, true);
+    const peakCount    = view.getUint32(tail + ID_LEN + 12, true);
+    const siblings: Uint8Array[] = [];
+    for (let i = 0; i < siblingCount; i++) {
+      siblings.push(raw.slice(i * ID_LEN, (i + 1) * ID_LEN));
+    }
+    const peaks: Uint8Array[] = [];
+    for (let i = 0; i < peakCount; i++) {
+      peaks.push(raw.slice(peaksAt + i * ID_LEN, peaksAt + (i + 1) * ID_LEN));
+    }
+    return {
+      siblings,
+      peaks,
+      peakIndex: view.getUint32(tail + ID_LEN + 16, true),
+      root:      raw.slice(tail, tail + ID_LEN),
+      leafCount: view.getBigUint64(tail + ID_LEN, true),
+      available: raw[tail + ID_LEN + 20] === 1,
+    };
+  }
+
+  /**
+   * Digest of a closed log segment. Survives ring eviction, so archived
+   * metadata for old seqs can be checked by rebuilding the segment subtree.
+   */
+  async getSegmentRoot(segment: bigint): Promise<SegmentRoot> {
+    const input = new Uint8Array(8);
+    new DataView(input.buffer).setBigUint64(0, segment, true);
+
+    const raw = await this.helper.queryContractFunction(
+      this.contractIndex,
+      FUNC.GET_SEGMENT_ROOT,
+      input
+    ) as Uint8Array;
+
+    // Output: [32 root][8 firstSeq][8 closedCount][4 firstTick][4 lastTick][2 epoch][1 found]
+    const view = new DataView(raw.buffer, raw.byteOffset);
+    return {
+      root:        raw.slice(0, ID_LEN),
+      firstSeq:    view.getBigUint64(ID_LEN, true),
+      closedCount: view.getBigUint64(ID_LEN + 8, true),
+      firstTick:   view.getUint32(ID_LEN + 16, true),
+      lastTick:    view.getUint32(ID_LEN + 20, true),
+      epoch:       view.getUint16(ID_LEN + 24, true),
+      found:       raw[ID_LEN + 26] === 1,
+    };
+  }
+
+  /**
+   * Poll a receiver's inbox watermark. Call getInbox only when latestSeq
+   * differs from the last value you saw.
+   */
+  async getInboxHead(receiverAddress: string): Promise<InboxHead> {
+    const input = this.helper.getBytesFromIdentity(receiverAddress);
+
+    const raw = await this.helper.queryContractFunction(
+      this.contractIndex,
+      FUNC.GET_INBOX_HEAD,
+      input
+    ) as Uint8Array;
+
+    // Output: [8 latestSeq][4 totalCount][4 lastTick][1 found]
+    const view = new DataView(raw.buffer, raw.byteOffset);
+    return {
+      latestSeq:  view.getBigUint64(0, true),
+      totalCount: view.getUint32(8, true),
+      lastTick:   view.getUint32(12, true),
+      found:      raw[16] === 1,
+    };
+  }
+
+  /**
+   * Decode a chain page: [RANGE_MAX x QM_MessageMeta][8 nextBeforeSeq][4 count][1 truncated]
+   */
+  private decodeMessagePage(raw: Uint8Array): InboxPage {
+    const view = new DataView(raw.buffer, raw.byteOffset);
+    const tail = RANGE_MAX * MESSAGE_META_SIZE;
+    const filled = view.getUint32(tail + 8, true);
+    const entries: MessageMetaEntry[] = [];
+    for (let i = 0; i < filled; i++) {
+      entries.push(this.decodeMessageMeta(raw, i * MESSAGE_META_SIZE));
+    }
+    return {
+      entries,
+      nextBeforeSeq: view.getBigUint64(tail, true),
+      truncated:     raw[tail + 12] === 1,
+    };
+  }
+
+  /**
+   * Decode one QM_MessageMeta struct at `offset`.
+   * Layout: [32 sender][32 receiver][32 contentHash][4 tick][4 nonce][8 seq][1 kind][3 pad]
+   *         [4 leafCount][8 pad]
+   */
+  private decodeMessageMeta(raw: Uint8Array, offset: number): MessageMetaEntry {
+    const view = new DataView(raw.buffer, raw.byteOffset);
+    const sender   = this.helper.getIdentityFromBytes(raw.slice(offset, offset + ID_LEN)); offset += ID_LEN;
+    const receiver = this.helper.getIdentityFromBytes(raw.slice(offset, offset + ID_LEN)); offset += ID_LEN;
+    const contentHash = raw.slice(offset, offset + HASH_LEN); offset += HASH_LEN;
+    const tick  = view.getUint32(offset, true); offset += 4;
+    const nonce = view.getUint32(offset, true); offset += 4;
+    const seq   = view.getBigUint64(offset, true);
+    const kind  = raw[offset + 8];
+    const leafCount = view.getUint32(offset + 12, true);
+    return { sender, receiver, contentHash, tick, nonce, valid: true, seq, kind, leafCount };
   }
 
   /**
@@ -242,4 +948,26 @@ export class QubicMessengerClient {
     const result = await this.helper.broadcastTransaction(tx) as Uint8Array;
     return result[0] === 1;
   }
+
+  /**
+   * Open a nonce lane for another device. Pass the returned lane with every
+   * post from that device; its nonces are then independent of your others.
+   */
+  async addDeviceLane(seed: string): Promise<DeviceLaneResult> {
+    const tx = await this.helper.createTransaction(
+      seed,
+      this.contractIndex,
+      PROC.ADD_DEVICE_LANE,
+      0,
+      new Uint8Array(0)
+    );
+    const result = await this.helper.broadcastTransaction(tx) as Uint8Array;
+
+    // Output: [1 lane][1 success][1 errorCode]
+    return {
+      lane:      result[0],
+      success:   result[1] === 1,
+      errorCode: result[2],
+    };
+  }
 }